@@ -40,10 +40,13 @@
 #include "src/lb_cimg_draw.h"
 #include "src/lb_macro_function.h"
 #include "src/lb_misc_function.h"
+#include "src/lb_fast_math.h"
 #include "src/lb_regression.h"
 #include "src/lb_tools.h"
+#include "src/lb_random.h"
 #include "src/lb_log_file.h"
 #include "src/lb_statistic_function.h"
+#include "src/lb_median_filter.h"
 #include "src/lb_data_type.h"
 #include "src/lb_math_model.h"
 #include "src/lb_particle_function.h"
@@ -54,6 +57,9 @@
 
 //sensor function
 #include "src/lb_lrf_basic.h"
+#include "src/lb_lrf_preprocess.h"
+#include "src/lb_lrf_motion_detect.h"
+#include "src/lb_lrf_downsample.h"
 #include "src/lb_lrf_object_detect.h"
 
 //object tracker
@@ -64,6 +70,7 @@
 
 //Localization and/or Mapping
 #include "src/lb_map2_grid.h"
+#include "src/lb_map2_correlative.h"
 #include "src/lb_mcl2.h"
 
 
@@ -106,11 +106,12 @@ inline void lb_draw_points_cimg(cimg8u& img,
 
     vec2f tmp;
     CImgList<int> cimg_points;
+    rigid2f rot = rigid2f::rotation(angle);
 
     for (size_t i = 0; i < points.size(); i++) {
         tmp = points[i];
         if (angle != 0.0)
-            tmp.rotate(angle);
+            tmp = rot.apply_rotation(tmp);
 
         lb_cimg_draw_check(tmp);
 
@@ -125,8 +126,13 @@ inline void lb_draw_points_cimg(cimg8u& img,
 }
 
 
+/**
+ * Draw a line object that refers to the scan points (lrf_object_record::begin/end),
+ * as output by the view based detectors into an lrf_object_arena.
+ */
 inline void lb_draw_lrf_line_object_cimg(cimg8u& img,
-                                         const lrf_object& line,
+                                         const lrf_object_record& line,
+                                         const std::vector<vec2f>& points,
                                          const unsigned char color[],
                                          LB_FLOAT scale = 1.0,
                                          LB_FLOAT angle = 0.0,
@@ -139,8 +145,10 @@ inline void lb_draw_lrf_line_object_cimg(cimg8u& img,
 
     lb_cimg_draw_offset_data();
 
-    vec2f p0 = line.points[0];
-    vec2f p1 = line.points[line.points.size() - 1];
+    if((line.begin < 0) || (line.end <= line.begin) || ((size_t)line.end > points.size())) return;
+
+    vec2f p0 = points[line.begin];
+    vec2f p1 = points[line.end - 1];
     LB_FLOAT m = line.extra_param[0];
     LB_FLOAT c = line.extra_param[1];
     vec2f l0 = p0;
@@ -163,8 +171,27 @@ inline void lb_draw_lrf_line_object_cimg(cimg8u& img,
     img.draw_line(l0.x, l0.y, l1.x, l1.y, color, 1.0);
 }
 
+inline void lb_draw_lrf_line_object_cimg(cimg8u& img,
+                                         const lrf_object& line,
+                                         const unsigned char color[],
+                                         LB_FLOAT scale = 1.0,
+                                         LB_FLOAT angle = 0.0,
+                                         int x_offset = -1,
+                                         int y_offset = -1,
+                                         bool flip_x = false,
+                                         bool flip_y = true)
+{
+    //points of the object, objects of the view based detectors without points
+    //are drawn with the scan points by the lrf_object_record overload
+    if(line.points.empty()) return;
+    lrf_object_record r = line;
+    r.begin = 0;
+    r.end = (int)line.points.size();
+    lb_draw_lrf_line_object_cimg(img, r, line.points, color, scale, angle, x_offset, y_offset, flip_x, flip_y);
+}
+
 inline void lb_draw_lrf_arc_object_cimg(cimg8u& img,
-                                        const lrf_object& arc,
+                                        const lrf_object_record& arc,
                                         const unsigned char color[],
                                         LB_FLOAT scale = 1.0,
                                         LB_FLOAT angle = 0.0,
@@ -209,10 +236,10 @@ inline void lb_draw_vfh_cimg(cimg8u& img,
     LB_FLOAT theta_step = (2*M_PI)/histogram.size();
     vec2f tmp;
 
+    //bin direction rotated by the drawing angle
+    rigid2f rot = rigid2f::rotation(angle);
     for(size_t i = 0; i < histogram.size(); i++) {
-        tmp = vec2f(1,0).get_rotate(theta_step*i) * histogram[i];
-        if(angle != 0)
-            tmp = tmp.get_rotate(angle);
+        tmp = rot.apply_rotation(vec2f(1,0).get_rotate(theta_step*i)) * histogram[i];
 
         lb_cimg_draw_check(tmp);
 
@@ -244,12 +271,13 @@ inline void lb_draw_paticle2(cimg8u& img,
 
     vec2i grid_pose;
     vec2f tmp, dir;
+    rigid2f rot = rigid2f::rotation(angle);
     for(size_t i = 0; i < p.size(); i++) {
         map.get_grid_coordinate(p[i].p.x, p[i].p.y, grid_pose);
 
         tmp = grid_pose * scale;
         if(angle != 0)
-            tmp = tmp.get_rotate(angle);
+            tmp = rot.apply_rotation(tmp);
 
         if(flip_x) tmp.x = dimx - tmp.x;
         if(flip_y) tmp.y = dimy - tmp.y;
@@ -260,7 +288,7 @@ inline void lb_draw_paticle2(cimg8u& img,
         if(draw_dir) {
             dir = vec2f(size_in_pixel * 2.0, 0.0).get_rotate(p[i].p.a);
             if(angle != 0)
-                dir = dir.get_rotate(angle);
+                dir = rot.apply_rotation(dir);
             lb_cimg_draw_check(dir);
             dir += tmp;
             img.draw_line(tmp.x, tmp.y, dir.x, dir.y, black);
@@ -288,6 +316,7 @@ inline void lb_draw_map2_grid_ray_cast(cimg8u& img,
     LB_FLOAT r, rad;
     vec2f tmp;
     vec2i tmp2;
+    rigid2f rot = rigid2f::rotation(angle);
     for(size_t i = 0; i < map.ray_casting_cache[grid.x][grid.y].size(); i++) {
         r = (map.ray_casting_cache[grid.x][grid.y][i]/map.resolution);
         rad = map.angle_res * i;
@@ -295,7 +324,7 @@ inline void lb_draw_map2_grid_ray_cast(cimg8u& img,
         tmp.y = r * sin(rad);
 
         if(angle != 0)
-            tmp = tmp.get_rotate(angle);
+            tmp = rot.apply_rotation(tmp);
         lb_cimg_draw_check(tmp);
 
         tmp2 = grid * scale;
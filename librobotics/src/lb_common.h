@@ -58,6 +58,7 @@
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/io.hpp>
+#include <boost/shared_ptr.hpp>
 #include "external/boost_matrix_inverse.h"
 
 //external tools
@@ -140,6 +141,21 @@
 #endif
 #endif
 
+// Thread local storage.
+//
+// 'librobotics_tls' marks plain data that each thread owns a copy of
+// (e.g. the default random engine).
+//
+#ifndef librobotics_tls
+#if defined(_MSC_VER)
+#define librobotics_tls __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define librobotics_tls __thread
+#else
+#define librobotics_tls
+#endif
+#endif
+
 // Output messages configuration.
 //
 // Define 'librobotics_debug' to : 0 to hide debug messages (quiet mode, but exceptions are still thrown).
@@ -186,5 +202,17 @@ typedef cimg_library::CImg<unsigned char> cimg8u;
 #include <GL/glut.h>
 #endif
 
+// OpenMP configuration.
+// (www.openmp.org)
+//
+// Define 'librobotics_use_openmp' to run parallel drivers (e.g. lb_lrf_object_detector)
+// on the OpenMP thread pool (compile with -fopenmp).
+//
+// Using OpenMP is not mandatory, the drivers run serially with the same output.
+//
+#if (librobotics_use_openmp == 1)
+#include <omp.h>
+#endif
+
 
 #endif /* LB_COMMON_H_ */
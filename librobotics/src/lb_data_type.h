@@ -33,14 +33,24 @@
 #include "lb_common.h"
 #include "lb_vec2.h"
 #include "lb_pose2.h"
+#include "lb_rigid2.h"
 
 namespace librobotics {
     //vector
     typedef vec2<LB_INT> vec2i;
     typedef vec2<LB_FLOAT> vec2f;
+    typedef vec2<float> vec2f32;
+    typedef vec2<double> vec2f64;
 
     //position
     typedef pose2<LB_FLOAT> pose2f;
+    typedef pose2<float> pose2f32;
+    typedef pose2<double> pose2f64;
+
+    //rigid transform
+    typedef rigid2<LB_FLOAT> rigid2f;
+    typedef rigid2<float> rigid2f32;
+    typedef rigid2<double> rigid2f64;
 
     //bounding box
     template<typename T>
@@ -77,21 +87,79 @@ namespace librobotics {
         std::vector<vec2f> points;
     };
 
-    //laser object
-    struct lrf_object {
-        std::vector<vec2f> points;
+    //laser segment as index range [begin, end) of the scan buffers
+    struct lrf_segment_view {
+        int begin;
+        int end;
+        int id;
+
+        lrf_segment_view() : begin(0), end(0), id(-1) { }
+        lrf_segment_view(int _begin, int _end, int _id = -1) : begin(_begin), end(_end), id(_id) { }
+
+        size_t size() const { return (end > begin) ? (end - begin) : 0; }
+        bool empty() const { return end <= begin; }
+    };
+
+    //laser object without points, points are begin/end in the scan buffer
+    struct lrf_object_record {
         lrf_object_type type;
         vec2f extra_point[3];
         LB_FLOAT extra_param[3];
         int  segment_id;
+        int  begin;     //first point in the scan buffer (-1 if not a single range)
+        int  end;       //one past last point in the scan buffer
 
-        lrf_object() :
+        lrf_object_record() :
             type(LRF_OBJ_SEGMENT),
-            segment_id(-1)
-        { }
+            segment_id(-1),
+            begin(-1),
+            end(-1)
+        {
+            extra_param[0] = extra_param[1] = extra_param[2] = 0;
+        }
+    };
+
+    //laser object
+    struct lrf_object : public lrf_object_record {
+        std::vector<vec2f> points;
+
+        lrf_object() { }
+        lrf_object(const lrf_object_record& r) : lrf_object_record(r) { }
+    };
+
+    /**
+     * Object records of one scan, reset() at the start of each scan. Slots of earlier
+     * scans are overwritten instead of released.
+     * Same push_back/pop_back/back/size/[] as std::vector, the detectors of
+     * lb_lrf_object_detect.h output into either.
+     */
+    struct lrf_object_arena {
+        typedef lrf_object_record value_type;
+
+        std::vector<lrf_object_record> record;
+        size_t n;
+
+        lrf_object_arena(size_t capacity = 0) : record(capacity), n(0) { }
+
+        void reset() { n = 0; }
+        void clear() { n = 0; }
+        size_t size() const { return n; }
+        bool empty() const { return n == 0; }
+
+        lrf_object_record& operator[](size_t i) { return record[i]; }
+        const lrf_object_record& operator[](size_t i) const { return record[i]; }
+        lrf_object_record& back() { return record[n - 1]; }
+        const lrf_object_record& back() const { return record[n - 1]; }
+
+        void push_back(const lrf_object_record& r) {
+            if(n < record.size()) record[n] = r;
+            else record.push_back(r);
+            n++;
+        }
+        void pop_back() { n--; }
     };
 
-    inline bool lrf_object_id_compare( const lrf_object& i, const lrf_object& j) {
+    inline bool lrf_object_id_compare( const lrf_object_record& i, const lrf_object_record& j) {
         return i.segment_id < j.segment_id;
     }
 
@@ -0,0 +1,258 @@
+/*
+ * lb_fast_math.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LB_FAST_MATH_H_
+#define LB_FAST_MATH_H_
+
+#include "lb_common.h"
+#include "lb_macro_function.h"
+#include "lb_misc_function.h"
+
+namespace librobotics {
+
+/**
+ * @defgroup fast_math Fast trigonometric kernels
+ * Math policies for hot loops. Each policy has static sincos(), atan2() and wrap()
+ * (to \f$[-\pi, \pi)\f$ with \f$\pi\f$ rounded to T)
+ * for float and double, call sites take the policy as template parameter.
+ * Maximum absolute error over \f$[-100\pi, 100\pi]\f$ in double precision:
+ *  - lb_math_exact: libm, wrap 1e-16 rad (2pi split in three parts)
+ *  - lb_math_fast: sincos 7e-12, atan2 4e-8 rad, wrap is lb_normalize_angle_t()
+ *  - lb_math_approx: sincos 4e-5, atan2 1.2e-5 rad, wrap rounded in T (2e-5 rad in float)
+ *
+ * In float precision lb_math_fast is within 2e-7 of libm. Inputs must stay below
+ * 1e9 rad, the reductions round by integer conversion.
+ * The kernels have no branch, table or library call, so the array loops vectorize
+ * at -O3. Measured with test/test_fast_math.cpp (double, ns per value, libm 9 / 14):
+ *  - -O2: fast sincos 8.4, atan2 6.0; approx 6.6, 5.4
+ *  - -O3: fast sincos 4.6, atan2 6.3; approx 3.6, 5.5
+ *  - -O3 -march=native (AVX2): fast sincos 1.1, atan2 0.8; approx 1.0, 0.8
+ * @{
+ */
+
+///Reduce angle to \f$[-\pi/4, \pi/4]\f$, k is the number of \f$\pi/2\f$ removed (|a| < 1e9)
+template<typename T>
+inline T lb_fast_reduce_half_pi(T a, int& k) {
+    //pi/2 = c1 + c2 + c3 (Cody-Waite), c1 and c2 are exact in float
+    const T c1 = (T)1.5703125;
+    const T c2 = (T)4.837512969970703125e-4;
+    const T c3 = (T)7.54978995489188217e-8;
+    //round by integer conversion, floor() is a library call without SSE4.1
+    T x = a * (T)(2.0 / M_PI);
+    k = (int)(x + ((x < 0) ? (T)-0.5 : (T)0.5));
+    T kf = (T)k;
+    return ((a - kf * c1) - kf * c2) - kf * c3;
+}
+
+///Select sin/cos of the full angle from the reduced ones and the quadrant, arithmetic only
+template<typename T>
+inline void lb_fast_quadrant(T sr, T cr, int k, T& s, T& c) {
+    T odd = (T)(k & 1);
+    T s_neg = (T)((k >> 1) & 1);                            //(k mod 4) >= 2
+    T c_neg = (T)(((k + 1) >> 1) & 1);                      //(k mod 4) is 1 or 2
+    T ss = sr + odd * (cr - sr);
+    T cc = cr + odd * (sr - cr);
+    s = ss * ((T)1 - (s_neg + s_neg));
+    c = cc * ((T)1 - (c_neg + c_neg));
+}
+
+///Fold an angle within one turn of \f$[-\pi, \pi)\f$ into it, \f$\pi\f$ rounded to T
+template<typename T>
+inline T lb_fast_fold_pi(T r) {
+    const T two_pi = (T)(2.0 * M_PI);
+    r = (r < -(T)M_PI) ? (r + two_pi) : r;
+    return (r >= (T)M_PI) ? (r - two_pi) : r;
+}
+
+///Angle in \f$[0, \pi]\f$ from the atan of the octant ratio
+template<typename T>
+inline T lb_fast_atan2_octant(T y, T x, T r) {
+    r = (fabs(y) > fabs(x)) ? ((T)M_PI_2 - r) : r;
+    r = (x < 0) ? ((T)M_PI - r) : r;
+    return (y < 0) ? -r : r;
+}
+
+///Ratio min(|x|,|y|)/max(|x|,|y|) in \f$[0, 1]\f$, zero for (0, 0)
+template<typename T>
+inline T lb_fast_atan2_ratio(T y, T x) {
+    T ax = fabs(x);
+    T ay = fabs(y);
+    T mx = LB_MAX(ax, ay);
+    T mn = LB_MIN(ax, ay);
+    return (mx > 0) ? (mn / mx) : (T)0;
+}
+
+/**
+ * Exact policy (libm).
+ */
+struct lb_math_exact {
+    template<typename T>
+    static inline void sincos(T a, T& s, T& c) {
+        s = sin(a);
+        c = cos(a);
+    }
+
+    template<typename T>
+    static inline T atan2(T y, T x) {
+        return std::atan2(y, x);
+    }
+
+    ///Wrap to \f$[-\pi, \pi)\f$, reduction in double with 2pi in three parts
+    template<typename T>
+    static inline T wrap(T a) {
+        const double c1 = 6.28125;                        //exact, few mantissa bits
+        const double c2 = 1.93500518798828125e-3;         //exact (2029 / 2^20)
+        const double c3 = 3.0199159819567529e-7;          //2pi - c1 - c2
+        double d = a;
+        double k = floor(d * (0.5 / M_PI) + 0.5);
+        //narrowing to float can round up to pi
+        return lb_fast_fold_pi((T)(((d - k * c1) - k * c2) - k * c3));
+    }
+};
+
+/**
+ * Fast policy, polynomial sincos (degree 11/12) and atan (degree 15).
+ */
+struct lb_math_fast {
+    template<typename T>
+    static inline void sincos(T a, T& s, T& c) {
+        int q;
+        T r = lb_fast_reduce_half_pi(a, q);
+        T r2 = r * r;
+        T sr = r * ((T)1 + r2 * ((T)(-1.0/6) + r2 * ((T)(1.0/120) + r2 * ((T)(-1.0/5040) +
+                 r2 * ((T)(1.0/362880) + r2 * (T)(-1.0/39916800))))));
+        T cr = (T)1 + r2 * ((T)(-1.0/2) + r2 * ((T)(1.0/24) + r2 * ((T)(-1.0/720) +
+                 r2 * ((T)(1.0/40320) + r2 * ((T)(-1.0/3628800) + r2 * (T)(1.0/479001600))))));
+        lb_fast_quadrant(sr, cr, q, s, c);
+    }
+
+    template<typename T>
+    static inline T atan2(T y, T x) {
+        //Abramowitz and Stegun 4.4.49
+        T t = lb_fast_atan2_ratio(y, x);
+        T t2 = t * t;
+        T r = t * ((T)0.9999993329 + t2 * ((T)-0.3332985605 + t2 * ((T)0.1994653599 +
+                t2 * ((T)-0.1390853351 + t2 * ((T)0.0964200441 + t2 * ((T)-0.0559098861 +
+                t2 * ((T)0.0218612288 + t2 * (T)-0.0040540580)))))));
+        return lb_fast_atan2_octant(y, x, r);
+    }
+
+    ///Wrap to \f$[-\pi, \pi)\f$, lb_normalize_angle_t() (one 2pi product in double)
+    template<typename T>
+    static inline T wrap(T a) {
+        return lb_normalize_angle_t<T>(a);
+    }
+};
+
+/**
+ * Approximate policy, polynomial sincos (degree 5/6) and atan (degree 9).
+ */
+struct lb_math_approx {
+    template<typename T>
+    static inline void sincos(T a, T& s, T& c) {
+        int q;
+        T r = lb_fast_reduce_half_pi(a, q);
+        T r2 = r * r;
+        T sr = r * ((T)1 + r2 * ((T)(-1.0/6) + r2 * (T)(1.0/120)));
+        T cr = (T)1 + r2 * ((T)(-1.0/2) + r2 * ((T)(1.0/24) + r2 * (T)(-1.0/720)));
+        lb_fast_quadrant(sr, cr, q, s, c);
+    }
+
+    template<typename T>
+    static inline T atan2(T y, T x) {
+        //Abramowitz and Stegun 4.4.47
+        T t = lb_fast_atan2_ratio(y, x);
+        T t2 = t * t;
+        T r = t * ((T)0.9998660 + t2 * ((T)-0.3302995 + t2 * ((T)0.1801410 +
+                t2 * ((T)-0.0851330 + t2 * (T)0.0208351))));
+        return lb_fast_atan2_octant(y, x, r);
+    }
+
+    ///Wrap to \f$[-\pi, \pi)\f$ in T only, rounding by integer conversion (|a| < 1e9)
+    template<typename T>
+    static inline T wrap(T a) {
+        T x = a * (T)(0.5 / M_PI);
+        T k = (T)(int)(x + ((x < 0) ? (T)-0.5 : (T)0.5));
+        //rounding half away from zero gives pi for -pi
+        return lb_fast_fold_pi(a - k * (T)(2.0 * M_PI));
+    }
+};
+
+///Policy used by library hot loops (set librobotics_use_fast_math to 1 for lb_math_fast)
+#if (librobotics_use_fast_math == 1)
+typedef lb_math_fast lb_math_default;
+#else
+typedef lb_math_exact lb_math_default;
+#endif
+
+/**
+ * Compute sin and cos of an array of angles.
+ * @param a input angles
+ * @param s output sin
+ * @param c output cos
+ * @param n number of angles
+ */
+template<typename M, typename T>
+inline void lb_sincos_array(const T* a, T* s, T* c, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        M::sincos(a[i], s[i], c[i]);
+    }
+}
+
+/**
+ * Compute atan2 of arrays.
+ * @param y input y
+ * @param x input x
+ * @param a output angles
+ * @param n number of values
+ */
+template<typename M, typename T>
+inline void lb_atan2_array(const T* y, const T* x, T* a, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        a[i] = M::atan2(y[i], x[i]);
+    }
+}
+
+/**
+ * Wrap an array of angles to \f$[-\pi, \pi)\f$ in place.
+ * @param a angles
+ * @param n number of angles
+ */
+template<typename M, typename T>
+inline void lb_wrap_angle_array(T* a, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        a[i] = M::wrap(a[i]);
+    }
+}
+
+/* @} */
+
+}
+
+#endif /* LB_FAST_MATH_H_ */
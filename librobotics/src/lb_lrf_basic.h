@@ -35,16 +35,17 @@
 #include "lb_macro_function.h"
 #include "lb_misc_function.h"
 #include "lb_data_type.h"
+#include "lb_median_filter.h"
 
 namespace librobotics {
 
 
 
-template<typename T>
+template<typename T, typename F>
 inline void lb_lrf_get_scan_point_from_scan_range(const std::vector<T>& ranges,
                                                   const std::vector<LB_FLOAT>& cos_table,
                                                   const std::vector<LB_FLOAT>& sin_table,
-                                                  std::vector<vec2f>& scan_points,
+                                                  std::vector<vec2<F> >& scan_points,
                                                   const int start,
                                                   const int end,
                                                   const int cluster,
@@ -85,8 +86,405 @@ inline void lb_lrf_get_scan_point_from_scan_range(const std::vector<T>& ranges,
     }
 }
 
-template<typename T>
-inline void lb_lrf_get_scan_range_from_scan_point(const std::vector<vec2f>& scan_points,
+/**
+ * Per beam cos/sin table for scan conversion in output order, build once per sensor.
+ */
+template<typename F>
+struct lb_lrf_scan_table_t {
+    std::vector<F> c;           //!< cos of each beam angle
+    std::vector<F> s;           //!< sin of each beam angle
+    bool flip;                  //!< beams are reversed and mirrored
+
+    lb_lrf_scan_table_t() : flip(false) { }
+
+    /**
+     * Build the table from sensor cos/sin tables,
+     * same indexing as lb_lrf_get_scan_point_from_scan_range().
+     * @param cos_table sensor cos table
+     * @param sin_table sensor sin table
+     * @param n number of beams (range values)
+     * @param start index of the first step
+     * @param cluster steps per beam
+     * @param _flip reverse and mirror the scan
+     */
+    void build(const std::vector<LB_FLOAT>& cos_table,
+               const std::vector<LB_FLOAT>& sin_table,
+               const size_t n,
+               const int start,
+               const int cluster,
+               const bool _flip = false)
+    {
+        size_t last = (n > 0) ? (start + ((n - 1) * cluster) + (cluster >> 1)) : 0;
+        if((n > 0) && ((cos_table.size() <= last) || (sin_table.size() <= last))) {
+            throw librobotics::LibRoboticsRuntimeException("cos/sin table size are not correct");
+        }
+        c.resize(n);
+        s.resize(n);
+        flip = _flip;
+        for(size_t i = 0; i < n; i++) {
+            size_t idx = start + (i*cluster) + (cluster >> 1);
+            size_t j = flip ? ((n - 1) - i) : i;
+            c[j] = (F)cos_table[idx];
+            s[j] = (F)(flip ? -sin_table[idx] : sin_table[idx]);
+        }
+    }
+
+    size_t size() const { return c.size(); }
+};
+
+typedef lb_lrf_scan_table_t<LB_FLOAT> lb_lrf_scan_table;
+
+/**
+ * Scan points in SoA layout with validity mask (1 if range is not zero).
+ */
+template<typename F>
+struct lb_lrf_scan_xy_t {
+    std::vector<F> x;
+    std::vector<F> y;
+    std::vector<unsigned char> valid;
+    size_t n_valid;
+
+    lb_lrf_scan_xy_t() : n_valid(0) { }
+
+    void resize(size_t n) {
+        if(x.size() != n) {
+            x.resize(n);
+            y.resize(n);
+            valid.resize(n);
+        }
+    }
+
+    size_t size() const { return x.size(); }
+};
+
+typedef lb_lrf_scan_xy_t<LB_FLOAT> lb_lrf_scan_xy;
+
+///Convert one beam, zero range gives (0, 0) and invalid without branch
+template<typename F>
+inline unsigned char lb_lrf_polar_to_xy(F r, F c, F s, F& x, F& y) {
+    x = r * c;
+    y = r * s;
+    return (unsigned char)(r != 0);
+}
+
+///Convert and transform one beam, (bx, by) is the rotated beam direction
+template<typename F>
+inline unsigned char lb_lrf_polar_to_xy(F r, F bx, F by, F tx, F ty, F& x, F& y) {
+    F m = (F)(r != 0);
+    x = m * ((r * bx) + tx);
+    y = m * ((r * by) + ty);
+    return (unsigned char)(r != 0);
+}
+
+/**
+ * Convert ranges to SoA scan points.
+ * The loop has no branch (zero range gives (0, 0) and valid = 0) so it vectorizes,
+ * ranges are read in their native type.
+ * @param ranges range values (table.size() values)
+ * @param table scan table
+ * @param scale range scale (e.g. 0.001 for mm to m)
+ * @param x output x
+ * @param y output y
+ * @param valid output mask
+ * @return number of valid points
+ */
+template<typename T, typename F>
+inline size_t lb_lrf_scan_to_xy(const T* ranges,
+                                const lb_lrf_scan_table_t<F>& table,
+                                const F scale,
+                                F* x,
+                                F* y,
+                                unsigned char* valid)
+{
+    size_t n = table.size();
+    if(n == 0) return 0;
+    const F* c = &table.c[0];
+    const F* s = &table.s[0];
+    size_t n_valid = 0;
+    if(table.flip) {
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = lb_lrf_polar_to_xy((F)ranges[(n - 1) - i] * scale, c[i], s[i], x[i], y[i]);
+            n_valid += valid[i];
+        }
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = lb_lrf_polar_to_xy((F)ranges[i] * scale, c[i], s[i], x[i], y[i]);
+            n_valid += valid[i];
+        }
+    }
+    return n_valid;
+}
+
+/**
+ * Convert ranges to SoA scan points and apply a rigid transform (sensor to world),
+ * invalid points are (0, 0).
+ * @param ranges range values (table.size() values)
+ * @param table scan table
+ * @param scale range scale
+ * @param t transform of the scan points
+ * @param x output x
+ * @param y output y
+ * @param valid output mask
+ * @return number of valid points
+ */
+template<typename T, typename F>
+inline size_t lb_lrf_scan_to_xy(const T* ranges,
+                                const lb_lrf_scan_table_t<F>& table,
+                                const F scale,
+                                const rigid2<F>& t,
+                                F* x,
+                                F* y,
+                                unsigned char* valid)
+{
+    size_t n = table.size();
+    if(n == 0) return 0;
+
+    const F ca = t.c;
+    const F sa = t.s;
+    const F tx = t.x;
+    const F ty = t.y;
+
+    const F* c = &table.c[0];
+    const F* s = &table.s[0];
+    size_t n_valid = 0;
+    if(table.flip) {
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = lb_lrf_polar_to_xy((F)ranges[(n - 1) - i] * scale,
+                                          (c[i] * ca) - (s[i] * sa), (s[i] * ca) + (c[i] * sa),
+                                          tx, ty, x[i], y[i]);
+            n_valid += valid[i];
+        }
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = lb_lrf_polar_to_xy((F)ranges[i] * scale,
+                                          (c[i] * ca) - (s[i] * sa), (s[i] * ca) + (c[i] * sa),
+                                          tx, ty, x[i], y[i]);
+            n_valid += valid[i];
+        }
+    }
+    return n_valid;
+}
+
+/**
+ * Convert ranges to SoA scan points and apply sensor mount and robot pose,
+ * same result as lb_lrf_scan_point_offset() on converted points (invalid points are (0, 0)).
+ * @param ranges range values (table.size() values)
+ * @param table scan table
+ * @param scale range scale
+ * @param local_offset sensor pose on the robot
+ * @param global_offset robot pose
+ * @param x output x
+ * @param y output y
+ * @param valid output mask
+ * @return number of valid points
+ */
+template<typename T, typename F>
+inline size_t lb_lrf_scan_to_xy(const T* ranges,
+                                const lb_lrf_scan_table_t<F>& table,
+                                const F scale,
+                                const pose2f& local_offset,
+                                const pose2f& global_offset,
+                                F* x,
+                                F* y,
+                                unsigned char* valid)
+{
+    return lb_lrf_scan_to_xy(ranges, table, scale,
+                             rigid2<F>(global_offset) * rigid2<F>(local_offset),
+                             x, y, valid);
+}
+
+/**
+ * Convert ranges to SoA scan points.
+ * @param ranges range values (ranges.size() must equal table.size())
+ * @param table scan table
+ * @param result output points
+ * @param scale range scale
+ */
+template<typename T, typename F>
+inline void lb_lrf_scan_to_xy(const std::vector<T>& ranges,
+                              const lb_lrf_scan_table_t<F>& table,
+                              lb_lrf_scan_xy_t<F>& result,
+                              const F scale = 1)
+{
+    if(ranges.size() != table.size()) {
+        throw librobotics::LibRoboticsRuntimeException("range and scan table size are not equal");
+    }
+    result.resize(ranges.size());
+    if(ranges.empty()) {
+        result.n_valid = 0;
+        return;
+    }
+    result.n_valid = lb_lrf_scan_to_xy(&ranges[0], table, scale, &result.x[0], &result.y[0], &result.valid[0]);
+}
+
+/**
+ * Convert ranges to SoA scan points in the global frame.
+ * @param ranges range values (ranges.size() must equal table.size())
+ * @param table scan table
+ * @param local_offset sensor pose on the robot
+ * @param global_offset robot pose
+ * @param result output points
+ * @param scale range scale
+ */
+template<typename T, typename F>
+inline void lb_lrf_scan_to_xy(const std::vector<T>& ranges,
+                              const lb_lrf_scan_table_t<F>& table,
+                              const pose2f& local_offset,
+                              const pose2f& global_offset,
+                              lb_lrf_scan_xy_t<F>& result,
+                              const F scale = 1)
+{
+    if(ranges.size() != table.size()) {
+        throw librobotics::LibRoboticsRuntimeException("range and scan table size are not equal");
+    }
+    result.resize(ranges.size());
+    if(ranges.empty()) {
+        result.n_valid = 0;
+        return;
+    }
+    result.n_valid = lb_lrf_scan_to_xy(&ranges[0], table, scale, local_offset, global_offset,
+                                       &result.x[0], &result.y[0], &result.valid[0]);
+}
+
+#define LB_Q14_SHIFT    14                      //!< fixed point Q14 fraction bits
+#define LB_Q14_ONE      (1 << LB_Q14_SHIFT)     //!< 1.0 in Q14
+
+/**
+ * Per beam cos/sin table in Q14 fixed point (int16) for integer scan conversion.
+ * Integer path: ranges stay in sensor unit (e.g. unsigned short millimetre from
+ * hokuyo_urg) through lb_lrf_range_threshold_filter(), lb_lrf_range_median_filter(),
+ * lb_lrf_range_segment() and lb_lrf_scan_to_xy_q14(), then lb_lrf_scan_xy_to_point()
+ * converts to floating point once at the end.
+ */
+struct lb_lrf_scan_table_q14 {
+    std::vector<short> c;       //!< cos of each beam angle (Q14)
+    std::vector<short> s;       //!< sin of each beam angle (Q14)
+    bool flip;                  //!< beams are reversed and mirrored
+
+    lb_lrf_scan_table_q14() : flip(false) { }
+
+    ///Build from a floating point scan table
+    template<typename F>
+    void build(const lb_lrf_scan_table_t<F>& table) {
+        size_t n = table.size();
+        c.resize(n);
+        s.resize(n);
+        flip = table.flip;
+        for(size_t i = 0; i < n; i++) {
+            c[i] = (short)LB_ROUND(table.c[i] * LB_Q14_ONE);
+            s[i] = (short)LB_ROUND(table.s[i] * LB_Q14_ONE);
+        }
+    }
+
+    ///Build from sensor cos/sin tables (see lb_lrf_scan_table_t::build())
+    void build(const std::vector<LB_FLOAT>& cos_table,
+               const std::vector<LB_FLOAT>& sin_table,
+               const size_t n,
+               const int start,
+               const int cluster,
+               const bool _flip = false)
+    {
+        lb_lrf_scan_table table;
+        table.build(cos_table, sin_table, n, start, cluster, _flip);
+        build(table);
+    }
+
+    size_t size() const { return c.size(); }
+};
+
+/**
+ * Convert integer ranges to SoA integer scan points in the range unit.
+ * Integer only and without branch (vectorizes to 16/32 bit lanes), ranges must be
+ * below 2^17 so r * cos fits in 32 bit. Result is rounded (max error 0.5 unit plus
+ * r * 2^-15 from the table).
+ * The output is not saturated: with P = short, x and y wrap above 32767 units, so
+ * ranges must stay below 32767 (32.7 m in millimetre).
+ * Use P = int for longer ranges.
+ * @param ranges range values (table.size() values)
+ * @param table Q14 scan table
+ * @param x output x
+ * @param y output y
+ * @param valid output mask
+ * @return number of valid points
+ */
+template<typename T, typename P>
+inline size_t lb_lrf_scan_to_xy_q14(const T* ranges,
+                                    const lb_lrf_scan_table_q14& table,
+                                    P* x,
+                                    P* y,
+                                    unsigned char* valid)
+{
+    size_t n = table.size();
+    if(n == 0) return 0;
+    const short* c = &table.c[0];
+    const short* s = &table.s[0];
+    const int half = 1 << (LB_Q14_SHIFT - 1);
+    size_t n_valid = 0;
+    //points and mask in separate loops (less aliasing checks, both vectorize)
+    if(table.flip) {
+        for(size_t i = 0; i < n; i++) {
+            int r = (int)ranges[(n - 1) - i];
+            x[i] = (P)(((r * c[i]) + half) >> LB_Q14_SHIFT);
+            y[i] = (P)(((r * s[i]) + half) >> LB_Q14_SHIFT);
+        }
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = (unsigned char)(ranges[(n - 1) - i] != 0);
+        }
+    } else {
+        for(size_t i = 0; i < n; i++) {
+            int r = (int)ranges[i];
+            x[i] = (P)(((r * c[i]) + half) >> LB_Q14_SHIFT);
+            y[i] = (P)(((r * s[i]) + half) >> LB_Q14_SHIFT);
+        }
+        for(size_t i = 0; i < n; i++) {
+            valid[i] = (unsigned char)(ranges[i] != 0);
+        }
+    }
+    for(size_t i = 0; i < n; i++) {
+        n_valid += valid[i];
+    }
+    return n_valid;
+}
+
+///lb_lrf_scan_to_xy_q14() into lb_lrf_scan_xy_t (same range limits)
+template<typename T, typename P>
+inline void lb_lrf_scan_to_xy_q14(const std::vector<T>& ranges,
+                                  const lb_lrf_scan_table_q14& table,
+                                  lb_lrf_scan_xy_t<P>& result)
+{
+    if(ranges.size() != table.size()) {
+        throw LibRoboticsRuntimeException("%s: scan size %d, table size %d", __FUNCTION__,
+                                          (int)ranges.size(), (int)table.size());
+    }
+    result.resize(table.size());
+    if(table.size() == 0) {
+        result.n_valid = 0;
+        return;
+    }
+    result.n_valid = lb_lrf_scan_to_xy_q14(&ranges[0], table, &result.x[0], &result.y[0], &result.valid[0]);
+}
+
+/**
+ * Final stage of the integer path, convert SoA scan points to floating point points.
+ * @param xy scan points (e.g. millimetre)
+ * @param scale unit scale (e.g. 0.001 for mm to m)
+ * @param points result, invalid points are (0, 0)
+ */
+template<typename P, typename F>
+inline void lb_lrf_scan_xy_to_point(const lb_lrf_scan_xy_t<P>& xy,
+                                    const F scale,
+                                    std::vector<vec2<F> >& points)
+{
+    size_t n = xy.size();
+    points.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        points[i].x = (F)xy.x[i] * scale;
+        points[i].y = (F)xy.y[i] * scale;
+    }
+}
+
+template<typename T, typename F>
+inline void lb_lrf_get_scan_range_from_scan_point(const std::vector<vec2<F> >& scan_points,
                                                   std::vector<T>& result,
                                                   const LB_FLOAT scale = 1.0)
 {
@@ -97,54 +495,89 @@ inline void lb_lrf_get_scan_range_from_scan_point(const std::vector<vec2f>& scan
     }
 }
 
-inline void lb_lrf_scan_point_offset(std::vector<vec2f>& scan_points,
+/**
+ * Transform scan points from sensor to world, points are transformed in place.
+ * Sensor mount and robot pose are composed once (see rigid2).
+ * @param scan_points scan points
+ * @param local_offset sensor pose on the robot
+ * @param global_offset robot pose
+ * @param ignore_zero keep (0, 0) points (no measurement)
+ */
+template<typename F>
+inline void lb_lrf_scan_point_offset(std::vector<vec2<F> >& scan_points,
                                      const pose2f& local_offset,
                                      const pose2f& global_offset,
                                      const bool ignore_zero = true)
 {
     size_t n = scan_points.size();
-    for(size_t i = 0; i < n; i++ ) {
-        if(ignore_zero) {
-            if(scan_points[i].is_zero()) {
-                scan_points[i].x = 0.0;
-                scan_points[i].y = 0.0;
-                continue;
-            }
-        }
-
-        scan_points[i].rotate(local_offset.a);
-        scan_points[i] += local_offset.get_vec2();
-        scan_points[i].rotate(global_offset.a);
-        scan_points[i] += global_offset.get_vec2();
-    }
+    if(n == 0) return;
+    lb_rigid2_apply(rigid2<F>(global_offset) * rigid2<F>(local_offset),
+                    &scan_points[0], &scan_points[0], n, ignore_zero);
 }
 
-inline void lb_lrf_get_scan_point_offset(const std::vector<vec2f>& scan_points,
+/**
+ * Transform scan points from sensor to world.
+ * @param scan_points scan points
+ * @param local_offset sensor pose on the robot
+ * @param global_offset robot pose
+ * @param result transformed points
+ * @param ignore_zero keep (0, 0) points (no measurement)
+ */
+template<typename F>
+inline void lb_lrf_get_scan_point_offset(const std::vector<vec2<F> >& scan_points,
                                          const pose2f& local_offset,
                                          const pose2f& global_offset,
-                                         std::vector<vec2f>& result,
+                                         std::vector<vec2<F> >& result,
                                          const bool ignore_zero = true)
 {
     size_t n = scan_points.size();
     if(result.size() < n) result.resize(n);
+    if(n == 0) return;
+    lb_rigid2_apply(rigid2<F>(global_offset) * rigid2<F>(local_offset),
+                    &scan_points[0], &result[0], n, ignore_zero);
+}
 
-    for(size_t i = 0; i < n; i++ ) {
-        if(ignore_zero) {
-            if(scan_points[i].is_zero()) {
-                result[i].x = 0.0;
-                result[i].y = 0.0;
-                continue;
-            }
-        }
-
-        result[i] = scan_points[i];
-        result[i].rotate(local_offset.a);
-        result[i] += local_offset.get_vec2();
-        result[i].rotate(global_offset.a);
-        result[i] += global_offset.get_vec2();
+/**
+ * Compute the range condition mask (EMPTY below min_range, FAR above max_range)
+ * of each beam. The mask is overwritten, other stages (mixed pixel, occlusion, motion)
+ * add their flags (lrf_range_condition bits) after this one.
+ * Branch free, the loop vectorizes.
+ * @param ranges range values
+ * @param n number of beams
+ * @param min_range minimum range
+ * @param max_range maximum range
+ * @param mask output condition mask (lrf_range_condition bits)
+ */
+template<typename T>
+inline void lb_lrf_range_condition_mask(const T* ranges,
+                                        const size_t n,
+                                        const T min_range,
+                                        const T max_range,
+                                        unsigned char* mask)
+{
+    for(size_t i = 0; i < n; i++) {
+        unsigned char e = (unsigned char)(ranges[i] < min_range);
+        unsigned char f = (unsigned char)(ranges[i] > max_range);
+        mask[i] = (unsigned char)((e * LRF_COND_EMPTY) | ((f & (e ^ 1)) * LRF_COND_FAR));
     }
 }
 
+template<typename T>
+inline void lb_lrf_range_condition_mask(const std::vector<T>& ranges,
+                                        std::vector<unsigned char>& mask,
+                                        const T min_range,
+                                        const T max_range)
+{
+    size_t n = ranges.size();
+    mask.resize(n);
+    if(n == 0) return;
+    lb_lrf_range_condition_mask(&ranges[0], n, min_range, max_range, &mask[0]);
+}
+
+/**
+ * Range condition of each beam (EMPTY or FAR, NONE otherwise).
+ * All flags are recomputed, nothing is kept from the previous frame.
+ */
 template<typename T>
 inline void lb_lrf_range_condition_check(const std::vector<T>& ranges,
                                          std::vector<lrf_range_condition>& cond,
@@ -152,15 +585,324 @@ inline void lb_lrf_range_condition_check(const std::vector<T>& ranges,
                                          const T max_range)
 {
     size_t n = ranges.size();
+    if(cond.size() != n) cond.resize(n, LRF_COND_NONE);
     for(size_t i = 0; i < n; i++ ) {
-        if(ranges[i] < min_range) {
-            cond[i] |= LRF_COND_EMPTY;
-        } else if(ranges[i] > max_range) {
-            cond[i] |= LRF_COND_FAR;
-        } else {
-            cond[i] = LRF_COND_NONE;
+        unsigned char e = (unsigned char)(ranges[i] < min_range);
+        unsigned char f = (unsigned char)(ranges[i] > max_range);
+        cond[i] = (lrf_range_condition)((e * LRF_COND_EMPTY) | ((f & (e ^ 1)) * LRF_COND_FAR));
+    }
+}
+
+///Edge flags of beam b with neighbours a and c (va, vb, vc: 1 if measured)
+template<typename T>
+inline unsigned char lb_lrf_edge_flag(const T a, const T b, const T c,
+                                      const unsigned char va,
+                                      const unsigned char vb,
+                                      const unsigned char vc,
+                                      const LB_FLOAT threshold,
+                                      const LB_FLOAT ratio)
+{
+    LB_FLOAT jump = threshold + (ratio * b);
+    LB_FLOAT da = (LB_FLOAT)b - (LB_FLOAT)a;
+    LB_FLOAT dc = (LB_FLOAT)b - (LB_FLOAT)c;
+    //both neighbours measured, b is between them and far from both
+    unsigned char mixed = va & vb & vc &
+        (unsigned char)((da * dc) < 0) & (unsigned char)(fabs(da) > jump) & (unsigned char)(fabs(dc) > jump);
+    //b is behind a measured neighbour
+    unsigned char occluded = vb & (mixed ^ 1) &
+        (unsigned char)((va & (unsigned char)(da > jump)) | (vc & (unsigned char)(dc > jump)));
+    return (unsigned char)((mixed * LRF_COND_MIXED) | (occluded * LRF_COND_OCCLUDED));
+}
+
+/**
+ * Mixed pixel and occlusion classifier over neighbouring beams, flags are added
+ * to the condition mask (run lb_lrf_range_condition_mask() first, beams with EMPTY
+ * or FAR are not measured).
+ * A beam is MIXED if its range lies between both neighbours and differs from both by
+ * more than the jump threshold (phantom point at a depth edge). A beam is OCCLUDED if
+ * it is farther than a neighbour by more than the jump threshold (it borders the
+ * shadow of a nearer object). The jump threshold grows with range: threshold + ratio * range.
+ * One pass, branch free (the inner loop vectorizes).
+ * @param ranges range values
+ * @param n number of beams
+ * @param mask condition mask of each beam (input and output)
+ * @param threshold range jump threshold
+ * @param ratio range dependent part of the jump threshold
+ */
+template<typename T>
+inline void lb_lrf_range_edge_mask(const T* ranges,
+                                   const size_t n,
+                                   unsigned char* mask,
+                                   const LB_FLOAT threshold,
+                                   const LB_FLOAT ratio = 0)
+{
+    if(n < 2) return;
+    const unsigned char no_range = LRF_COND_EMPTY | LRF_COND_FAR;
+
+    //first and last beam have one neighbour
+    unsigned char v0 = (mask[0] & no_range) == 0;
+    unsigned char v1 = (mask[1] & no_range) == 0;
+    unsigned char vl = (mask[n - 1] & no_range) == 0;
+    unsigned char vl1 = (mask[n - 2] & no_range) == 0;
+    unsigned char first = lb_lrf_edge_flag(ranges[1], ranges[0], ranges[1], v1, v0, (unsigned char)0, threshold, ratio);
+    unsigned char last = lb_lrf_edge_flag(ranges[n - 2], ranges[n - 1], ranges[n - 2], vl1, vl, (unsigned char)0, threshold, ratio);
+
+    //blocks of flags are computed before writing, so the loop has no dependence on mask
+    unsigned char flag[64];
+    for(size_t i0 = 1; i0 + 1 < n; i0 += 64) {
+        size_t m = LB_MIN((size_t)64, (n - 1) - i0);
+        for(size_t j = 0; j < m; j++) {
+            size_t i = i0 + j;
+            flag[j] = lb_lrf_edge_flag(ranges[i - 1], ranges[i], ranges[i + 1],
+                                       (unsigned char)((mask[i - 1] & no_range) == 0),
+                                       (unsigned char)((mask[i] & no_range) == 0),
+                                       (unsigned char)((mask[i + 1] & no_range) == 0),
+                                       threshold, ratio);
+        }
+        for(size_t j = 0; j < m; j++) {
+            mask[i0 + j] |= flag[j];
         }
     }
+    mask[0] |= first;
+    mask[n - 1] |= last;
+}
+
+template<typename T>
+inline void lb_lrf_range_edge_mask(const std::vector<T>& ranges,
+                                   std::vector<unsigned char>& mask,
+                                   const LB_FLOAT threshold,
+                                   const LB_FLOAT ratio = 0)
+{
+    size_t n = ranges.size();
+    if(mask.size() != n) {
+        throw LibRoboticsRuntimeException("%s: mask size %d, expected %d", __FUNCTION__,
+                                          (int)mask.size(), (int)n);
+    }
+    if(n == 0) return;
+    lb_lrf_range_edge_mask(&ranges[0], n, &mask[0], threshold, ratio);
+}
+
+/**
+ * Bitplane of beams (one bit per beam, 64 beams per word).
+ * Built from a condition mask, set bits are the usable beams. Consumers iterate
+ * the set bits with next() (count trailing zero) instead of testing every beam.
+ */
+struct lb_lrf_beam_bits {
+    std::vector<boost::uint64_t> word;      //!< bits, bits after n are 0
+    size_t n;                               //!< number of beams
+
+    lb_lrf_beam_bits() : n(0) { }
+
+    ///Resize and clear all bits (does not allocate if the size does not grow)
+    void resize(const size_t _n) {
+        n = _n;
+        word.assign((n + 63) >> 6, 0);
+    }
+
+    /**
+     * Set bits of beams without any of the reject flags.
+     * @param mask condition mask of each beam
+     * @param _n number of beams
+     * @param reject flags that make a beam unusable
+     */
+    void build(const unsigned char* mask, const size_t _n, const unsigned char reject = 0xff) {
+        resize(_n);
+        for(size_t w = 0; w < word.size(); w++) {
+            size_t i0 = w << 6;
+            size_t m = LB_MIN((size_t)64, n - i0);
+            boost::uint64_t b = 0;
+            for(size_t j = 0; j < m; j++) {
+                b |= (boost::uint64_t)((mask[i0 + j] & reject) == 0) << j;
+            }
+            word[w] = b;
+        }
+    }
+
+    void build(const std::vector<unsigned char>& mask, const unsigned char reject = 0xff) {
+        if(mask.empty()) {
+            resize(0);
+            return;
+        }
+        build(&mask[0], mask.size(), reject);
+    }
+
+    bool test(const size_t i) const { return (word[i >> 6] >> (i & 63)) & 1; }
+    void set(const size_t i) { word[i >> 6] |= ((boost::uint64_t)1 << (i & 63)); }
+    void reset(const size_t i) { word[i >> 6] &= ~((boost::uint64_t)1 << (i & 63)); }
+
+    ///Number of set bits
+    size_t count() const {
+        size_t c = 0;
+        for(size_t w = 0; w < word.size(); w++) {
+            c += lb_popcount64(word[w]);
+        }
+        return c;
+    }
+
+    ///First set bit at or after i (-1 if none)
+    int next(const size_t i) const {
+        if(i >= n) return -1;
+        size_t w = i >> 6;
+        boost::uint64_t b = word[w] & ((~(boost::uint64_t)0) << (i & 63));
+        while(b == 0) {
+            if(++w >= word.size()) return -1;
+            b = word[w];
+        }
+        return (int)((w << 6) + lb_ctz64(b));
+    }
+
+    ///Last set bit (-1 if none)
+    int last() const {
+        for(size_t w = word.size(); w > 0; w--) {
+            if(word[w - 1]) return (int)(((w - 1) << 6) + lb_bsr64(word[w - 1]));
+        }
+        return -1;
+    }
+
+    ///Index of all set bits (ascending)
+    void get_index(std::vector<int>& index) const {
+        index.clear();
+        for(size_t w = 0; w < word.size(); w++) {
+            boost::uint64_t b = word[w];
+            while(b) {
+                index.push_back((int)((w << 6) + lb_ctz64(b)));
+                b &= b - 1;
+            }
+        }
+    }
+};
+
+/**
+ * Usable beams of a scan: not zero, not longer than max_range and without
+ * condition flag (if cond is given).
+ * @param z relative LRF measurement point
+ * @param valid result bitplane
+ * @param max_range maximum beam range (<= 0 for no limit)
+ * @param cond optional condition of each beam (lrf_range_condition or u8 mask)
+ */
+template<typename F, typename M>
+inline void lb_lrf_get_valid_beam(const std::vector<vec2<F> >& z,
+                                  lb_lrf_beam_bits& valid,
+                                  const LB_FLOAT max_range,
+                                  const M* cond)
+{
+    size_t n = z.size();
+    valid.resize(n);
+    F r2 = (F)((max_range > 0) ? LB_SQR(max_range) : (std::numeric_limits<F>::max)());
+    for(size_t w = 0; w < valid.word.size(); w++) {
+        size_t i0 = w << 6;
+        size_t m = LB_MIN((size_t)64, n - i0);
+        boost::uint64_t b = 0;
+        for(size_t j = 0; j < m; j++) {
+            const vec2<F>& p = z[i0 + j];
+            F d = (p.x * p.x) + (p.y * p.y);
+            bool ok = ((p.x != 0) | (p.y != 0)) & (d <= r2) & ((cond ? (int)cond[i0 + j] : 0) == 0);
+            b |= (boost::uint64_t)ok << j;
+        }
+        valid.word[w] = b;
+    }
+}
+
+template<typename F>
+inline void lb_lrf_get_valid_beam(const std::vector<vec2<F> >& z,
+                                  lb_lrf_beam_bits& valid,
+                                  const LB_FLOAT max_range = 0)
+{
+    lb_lrf_get_valid_beam(z, valid, max_range, (const unsigned char*)NULL);
+}
+
+/**
+ * Select beams that spread over the scan angle from the usable beams in valid.
+ * The angle span of the valid beams is divided into max_beams equal sectors and
+ * the beam nearest to each sector center is kept.
+ * Beam angles must be monotonic along the scan (normal LRF order).
+ * @param z relative LRF measurement point
+ * @param valid usable beams (see lb_lrf_get_valid_beam())
+ * @param index result beam index (ascending)
+ * @param max_beams maximum number of selected beams
+ * @return number of selected beams
+ */
+template<typename F>
+inline size_t lb_lrf_select_beam(const std::vector<vec2<F> >& z,
+                                 const lb_lrf_beam_bits& valid,
+                                 std::vector<int>& index,
+                                 const size_t max_beams)
+{
+    index.clear();
+    if((z.size() == 0) || (max_beams == 0))
+        return 0;
+
+    //angle span of valid beams
+    int first = valid.next(0);
+    int last = valid.last();
+    if(first < 0)
+        return 0;
+
+    LB_FLOAT a_first = z[first].theta();
+    LB_FLOAT span = z[last].theta() - a_first;
+    LB_FLOAT width = span / max_beams;
+    if(fabs(width) < LB_IS_ZERO) {
+        index.push_back(first);
+        return 1;
+    }
+
+    //sweep over the valid beams, keep the beam nearest to each sector center
+    int sector = -1, best = -1;
+    LB_FLOAT best_dist = 0, pos, dist;
+    for(int i = first; i >= 0; i = valid.next(i + 1)) {
+        pos = (z[i].theta() - a_first) / width;
+        int s = LB_MIN((int)pos, (int)max_beams - 1);
+        dist = fabs(pos - (s + 0.5));
+        if(s != sector) {
+            if(best >= 0) index.push_back(best);
+            sector = s;
+            best = i;
+            best_dist = dist;
+        } else if(dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    if(best >= 0) index.push_back(best);
+    return index.size();
+}
+
+/**
+ * Select beams that spread over the scan angle (e.g. for MCL measurement update).
+ * The angle span of the valid beams is divided into max_beams equal sectors and
+ * the beam nearest to each sector center is kept. Zero beams, beams longer than
+ * max_range and beams with any condition flag are skipped.
+ * Beam angles must be monotonic along the scan (normal LRF order).
+ * @param z relative LRF measurement point
+ * @param index result beam index (ascending)
+ * @param max_beams maximum number of selected beams
+ * @param max_range maximum beam range (<= 0 for no limit)
+ * @param cond optional range condition of each beam
+ * @return number of selected beams
+ */
+template<typename F>
+inline size_t lb_lrf_select_beam(const std::vector<vec2<F> >& z,
+                                 std::vector<int>& index,
+                                 const size_t max_beams,
+                                 const LB_FLOAT max_range = 0,
+                                 const std::vector<lrf_range_condition>* cond = NULL)
+{
+    lb_lrf_beam_bits valid;
+    lb_lrf_get_valid_beam(z, valid, max_range, (cond && !cond->empty()) ? &(*cond)[0] : NULL);
+    return lb_lrf_select_beam(z, valid, index, max_beams);
+}
+
+///Select beams with a u8 condition mask (see lb_lrf_range_condition_mask())
+template<typename F>
+inline size_t lb_lrf_select_beam(const std::vector<vec2<F> >& z,
+                                 std::vector<int>& index,
+                                 const size_t max_beams,
+                                 const LB_FLOAT max_range,
+                                 const std::vector<unsigned char>& mask)
+{
+    lb_lrf_beam_bits valid;
+    lb_lrf_get_valid_beam(z, valid, max_range, mask.empty() ? NULL : &mask[0]);
+    return lb_lrf_select_beam(z, valid, index, max_beams);
 }
 
 template<typename T>
@@ -182,51 +924,79 @@ inline void lb_lrf_range_threshold_filter(std::vector<T>& ranges,
     }
 }
 
+/**
+ * Median filter of range values, edge values are replicated.
+ * Window up to 9 use sorting networks, larger window use a sliding double heap.
+ * @param ranges input range values
+ * @param result filtered range values (must not be ranges)
+ * @param half_windows_size half window size
+ * @param ws sliding median storage for large windows (reused between calls)
+ */
 template<typename T>
-inline void lb_lrf_range_median_filter(std::vector<T>& ranges,
-                                       const size_t half_windows_size = 2)
+inline void lb_lrf_range_median_filter(const std::vector<T>& ranges,
+                                       std::vector<T>& result,
+                                       const size_t half_windows_size,
+                                       lb_sliding_median_t<T>& ws)
 {
     size_t n = ranges.size();
-    if(n < ((half_windows_size * 2) + 1))
-        return;
+    if(result.size() != n) result.resize(n);
+    if(n == 0) return;
+    lb_median_filter(&ranges[0], &result[0], n, (int)half_windows_size, ws);
+}
 
-    std::vector<T> r((half_windows_size * 2) + 1, 0);
-    int k = 0, l = 0;
-    for(size_t i = 0; i < n; i++) {
-        k = 0;
-        for(int j = i - half_windows_size ; j <= (int)(i + half_windows_size); j++) {
-            l = (j < 0) ? 0 : j;
-            l = (j >= (int)n) ? (n - 1) : l;
-            r[k] = ranges[l];
-            k++;
-        }
-        std::sort(r.begin(), r.end());
-        ranges[i] = r[half_windows_size];
-    }
+/**
+ * Median filter of range values into a separate output.
+ * @param ranges input range values
+ * @param result filtered range values (must not be ranges)
+ * @param half_windows_size half window size
+ */
+template<typename T>
+inline void lb_lrf_range_median_filter(const std::vector<T>& ranges,
+                                       std::vector<T>& result,
+                                       const size_t half_windows_size = 2)
+{
+    lb_sliding_median_t<T> ws;
+    lb_lrf_range_median_filter(ranges, result, half_windows_size, ws);
 }
 
+/**
+ * Median filter of range values in place (filtered from a copy of the input).
+ * @param ranges range values
+ * @param half_windows_size half window size
+ */
 template<typename T>
-inline int lb_lrf_range_segment(const std::vector<T>& ranges,
-                                std::vector<int>& seg,
+inline void lb_lrf_range_median_filter(std::vector<T>& ranges,
+                                       const size_t half_windows_size = 2)
+{
+    std::vector<T> input(ranges);
+    lb_lrf_range_median_filter(input, ranges, half_windows_size);
+}
+
+/**
+ * Range segmentation, a range jump above threshold starts a new segment.
+ * @param ranges range values
+ * @param mask optional condition mask, beams with any flag are not measured (NULL for none)
+ * @param n number of beams
+ * @param seg result segment of each beam (1..n_segment, -1 if none)
+ * @param threshold range jump threshold
+ * @param min_range beams not longer than min_range are not measured
+ * @return number of segments
+ */
+template<typename T>
+inline int lb_lrf_range_segment(const T* ranges,
+                                const unsigned char* mask,
+                                const size_t n,
+                                int* seg,
                                 const T threshold,
                                 const T min_range = 0)
 {
-    size_t n = ranges.size();
-    if(seg.size() != n) {
-        seg.resize(n, -1);
-    } else {
-        for(size_t i = 0; i < n; i++) {
-            seg[i] = -1;
-        }
-    }
-
     bool new_segment = true;
     T last_range = 0;
     int n_segment = 0;
     T range_diff = 0;
 
     for(size_t i = 0; i < n; i++) {
-        if(ranges[i] > min_range) {
+        if((ranges[i] > min_range) && (!mask || (mask[i] == 0))) {
             if(new_segment) {
                 n_segment++;
 
@@ -235,8 +1005,9 @@ inline int lb_lrf_range_segment(const std::vector<T>& ranges,
                 new_segment = false;
                 last_range = ranges[i];
             } else {
-                range_diff = ranges[i] - last_range;
-                if(fabs((double)range_diff) > threshold) {
+                //absolute difference without sign change (also for unsigned ranges)
+                range_diff = (ranges[i] > last_range) ? (ranges[i] - last_range) : (last_range - ranges[i]);
+                if(range_diff > threshold) {
                     //end current segment
                     n_segment++;
 
@@ -263,7 +1034,37 @@ inline int lb_lrf_range_segment(const std::vector<T>& ranges,
 }
 
 template<typename T>
-inline int lb_lrf_point_segment(const std::vector<vec2f>& points,
+inline int lb_lrf_range_segment(const std::vector<T>& ranges,
+                                std::vector<int>& seg,
+                                const T threshold,
+                                const T min_range = 0)
+{
+    size_t n = ranges.size();
+    seg.resize(n);
+    if(n == 0) return 0;
+    return lb_lrf_range_segment(&ranges[0], (const unsigned char*)NULL, n, &seg[0], threshold, min_range);
+}
+
+///Range segmentation, beams with any flag in mask are not measured
+template<typename T>
+inline int lb_lrf_range_segment(const std::vector<T>& ranges,
+                                const std::vector<unsigned char>& mask,
+                                std::vector<int>& seg,
+                                const T threshold,
+                                const T min_range = 0)
+{
+    size_t n = ranges.size();
+    if(mask.size() != n) {
+        throw LibRoboticsRuntimeException("%s: mask size %d, expected %d", __FUNCTION__,
+                                          (int)mask.size(), (int)n);
+    }
+    seg.resize(n);
+    if(n == 0) return 0;
+    return lb_lrf_range_segment(&ranges[0], &mask[0], n, &seg[0], threshold, min_range);
+}
+
+template<typename F, typename T>
+inline int lb_lrf_point_segment(const std::vector<vec2<F> >& points,
                                 std::vector<int>& seg,
                                 const T threshold,
                                 const T min_range = 0)
@@ -278,7 +1079,7 @@ inline int lb_lrf_point_segment(const std::vector<vec2f>& points,
     }
 
     bool new_segment = true;
-    vec2f last_point;
+    vec2<F> last_point;
     int n_segment = 0;
     LB_FLOAT dist_diff = 0;
 
@@ -365,6 +1166,33 @@ inline void lb_lrf_create_segment(const std::vector<T>& input,
 }
 
 
+
+/**
+ * Get views of the segments in seg (from lb_lrf_range_segment() or lb_lrf_point_segment()),
+ * without copying points. A view is a run of equal segment number, empty runs are skipped.
+ * @param seg segment of each point (-1 if none)
+ * @param views segment views (id is the segment number)
+ * @return number of views
+ */
+inline size_t lb_lrf_get_segment_view(const std::vector<int>& seg,
+                                      std::vector<lrf_segment_view>& views)
+{
+    views.clear();
+    size_t n = seg.size();
+    size_t i = 0;
+    while(i < n) {
+        if(seg[i] == -1) {
+            i++;
+            continue;
+        }
+        size_t begin = i;
+        int id = seg[i];
+        while((i < n) && (seg[i] == id)) i++;
+        views.push_back(lrf_segment_view(begin, i, id));
+    }
+    return views.size();
+}
+
 }
 
 
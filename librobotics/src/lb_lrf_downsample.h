@@ -0,0 +1,223 @@
+/*
+ * lb_lrf_downsample.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LB_LRF_DOWNSAMPLE_H_
+#define LB_LRF_DOWNSAMPLE_H_
+
+#include "lb_common.h"
+#include "lb_exception.h"
+#include "lb_data_type.h"
+#include "lb_lrf_basic.h"
+
+namespace librobotics {
+
+/**
+ * Scan point downsampling.
+ * voxel() keeps the first point of each grid cell, adaptive() keeps a point when it is
+ * at least a given spacing from the last kept point (near beams, which are dense, are
+ * dropped more than far beams). Points of different segments or with different condition
+ * flags are never merged, output keeps the scan order, so segments stay contiguous and
+ * seg, mask and index (source point of each output point) stay valid.
+ * (0, 0) points (no return) are dropped. Both run in linear time, buffers are kept,
+ * so scans of the same size do not allocate after the first one.
+ */
+template<typename F>
+struct lb_lrf_downsample_t {
+    std::vector<vec2<F> > points;           //!< downsampled points
+    std::vector<int> index;                 //!< source index of each point
+    std::vector<int> seg;                   //!< segment of each point (-1 if none)
+    std::vector<unsigned char> mask;        //!< condition mask of each point (0 if none)
+
+    std::vector<int> slot_stamp;            //!< voxel hash, frame stamp of each slot
+    std::vector<int> slot_x;                //!< voxel hash, cell x
+    std::vector<int> slot_y;                //!< voxel hash, cell y
+    std::vector<int> slot_seg;              //!< voxel hash, segment
+    std::vector<unsigned char> slot_mask;   //!< voxel hash, flags
+    int stamp;                              //!< current frame stamp
+
+    lb_lrf_downsample_t() : stamp(0) { }
+
+    /**
+     * Voxel grid downsampling.
+     * @param z scan points
+     * @param size cell size
+     * @param seg_in optional segment of each point
+     * @param mask_in optional condition mask of each point
+     * @return number of points
+     */
+    size_t voxel(const std::vector<vec2<F> >& z,
+                 const F size,
+                 const std::vector<int>* seg_in = NULL,
+                 const std::vector<unsigned char>* mask_in = NULL)
+    {
+        if(size <= 0) {
+            throw LibRoboticsRuntimeException("%s: invalid voxel size %f", __FUNCTION__, (double)size);
+        }
+        size_t n = z.size();
+        check_input(n, seg_in, mask_in);
+        prepare(n);
+
+        //hash table with at least 2n slots, stamps avoid clearing it
+        size_t cap = 16;
+        while(cap < 2 * n) cap <<= 1;
+        if(slot_stamp.size() != cap) {
+            slot_stamp.assign(cap, 0);
+            slot_x.resize(cap);
+            slot_y.resize(cap);
+            slot_seg.resize(cap);
+            slot_mask.resize(cap);
+            stamp = 0;
+        }
+        if(++stamp == (std::numeric_limits<int>::max)()) {
+            slot_stamp.assign(cap, 0);
+            stamp = 1;
+        }
+        const size_t hmask = cap - 1;
+        const F inv = (F)1 / size;
+
+        for(size_t i = 0; i < n; i++) {
+            if(z[i].is_zero()) continue;
+            int cx = (int)floor(z[i].x * inv);
+            int cy = (int)floor(z[i].y * inv);
+            int s = seg_in ? (*seg_in)[i] : -1;
+            unsigned char m = mask_in ? (*mask_in)[i] : (unsigned char)0;
+            size_t key = ((size_t)(unsigned)s * 257u) + m;
+
+            //linear probing
+            size_t h = (((size_t)cx * 73856093u) ^ ((size_t)cy * 19349663u) ^ (key * 83492791u)) & hmask;
+            bool found = false;
+            while(slot_stamp[h] == stamp) {
+                if((slot_x[h] == cx) && (slot_y[h] == cy) && (slot_seg[h] == s) && (slot_mask[h] == m)) {
+                    found = true;
+                    break;
+                }
+                h = (h + 1) & hmask;
+            }
+            if(found) continue;
+
+            slot_stamp[h] = stamp;
+            slot_x[h] = cx;
+            slot_y[h] = cy;
+            slot_seg[h] = s;
+            slot_mask[h] = m;
+            add(z, i, s, m);
+        }
+        return points.size();
+    }
+
+    /**
+     * Range adaptive decimation along the scan.
+     * A point is kept if it is at least spacing from the last kept point, or if segment
+     * or flags change. The last point of each segment is always kept.
+     * @param z scan points
+     * @param spacing minimum distance between kept points
+     * @param seg_in optional segment of each point
+     * @param mask_in optional condition mask of each point
+     * @return number of points
+     */
+    size_t adaptive(const std::vector<vec2<F> >& z,
+                    const F spacing,
+                    const std::vector<int>* seg_in = NULL,
+                    const std::vector<unsigned char>* mask_in = NULL)
+    {
+        size_t n = z.size();
+        check_input(n, seg_in, mask_in);
+        prepare(n);
+
+        const F spacing2 = spacing * spacing;
+        int last = -1;          //last kept point
+        int pending = -1;       //last dropped point since then
+        int last_s = 0;
+        unsigned char last_m = 0;
+        for(size_t i = 0; i < n; i++) {
+            if(z[i].is_zero()) continue;
+            int s = seg_in ? (*seg_in)[i] : -1;
+            unsigned char m = mask_in ? (*mask_in)[i] : (unsigned char)0;
+
+            bool group = (last >= 0) && (s == last_s) && (m == last_m);
+            if(group && ((z[i] - z[last]).sqr_size() < spacing2)) {
+                pending = (int)i;
+                continue;
+            }
+            //keep the end of the previous segment
+            if(!group && (pending >= 0)) {
+                add(z, pending, last_s, last_m);
+            }
+            add(z, i, s, m);
+            last = (int)i;
+            last_s = s;
+            last_m = m;
+            pending = -1;
+        }
+        if(pending >= 0) {
+            add(z, pending, last_s, last_m);
+        }
+        return points.size();
+    }
+
+    ///Segment views of the downsampled points (see lb_lrf_get_segment_view())
+    size_t get_segment_view(std::vector<lrf_segment_view>& views) const {
+        return lb_lrf_get_segment_view(seg, views);
+    }
+
+    inline void check_input(size_t n,
+                            const std::vector<int>* seg_in,
+                            const std::vector<unsigned char>* mask_in) const
+    {
+        if((seg_in && (seg_in->size() != n)) || (mask_in && (mask_in->size() != n))) {
+            throw LibRoboticsRuntimeException("%s: segment or mask size does not match %d points",
+                                              __FUNCTION__, (int)n);
+        }
+    }
+
+    inline void prepare(size_t n) {
+        points.clear();
+        index.clear();
+        seg.clear();
+        mask.clear();
+        points.reserve(n);
+        index.reserve(n);
+        seg.reserve(n);
+        mask.reserve(n);
+    }
+
+    inline void add(const std::vector<vec2<F> >& z, size_t i, int s, unsigned char m) {
+        points.push_back(z[i]);
+        index.push_back((int)i);
+        seg.push_back(s);
+        mask.push_back(m);
+    }
+};
+
+typedef lb_lrf_downsample_t<LB_FLOAT> lb_lrf_downsample;
+
+}
+
+#endif /* LB_LRF_DOWNSAMPLE_H_ */
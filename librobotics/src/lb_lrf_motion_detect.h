@@ -0,0 +1,261 @@
+/*
+ * lb_lrf_motion_detect.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LB_LRF_MOTION_DETECT_H_
+#define LB_LRF_MOTION_DETECT_H_
+
+#include "lb_common.h"
+#include "lb_exception.h"
+#include "lb_data_type.h"
+#include "lb_fast_math.h"
+#include "lb_lrf_basic.h"
+
+namespace librobotics {
+
+/**
+ * Configuration of LRF motion detection, ranges are in point unit.
+ */
+struct lb_lrf_motion_configuration {
+    LB_FLOAT threshold;             //!< minimum intrusion into free space of a moving return
+    LB_FLOAT ratio;                 //!< range dependent part of threshold
+    int n_history;                  //!< number of previous scans in the background model
+    int neighbour;                  //!< z-buffer neighbour bins used for each beam
+    LB_FLOAT max_range;             //!< returns farther than this are not checked (<= 0 for no limit)
+
+    lb_lrf_motion_configuration() :
+        threshold(0.2),
+        ratio(0.02),
+        n_history(1),
+        neighbour(1),
+        max_range(0)
+    { }
+};
+
+/**
+ * Per-beam motion detection by scan differencing.
+ * Previous scans are kept in world coordinate (sensor pose from odometry). Every frame
+ * they are transformed into the current sensor frame (ego-motion compensation) and drawn
+ * into a polar z-buffer with one bin per beam, the nearest point of a scan wins.
+ * A current return is moving (LRF_COND_MOVE) if it lies in front of the space seen free
+ * by any background scan (nearest z-buffer range of the beam and its neighbours minus
+ * the threshold). Returns where the background has no point are not moving, so static
+ * structure and newly seen areas are not flagged.
+ * setup() sizes the history ring and z-buffer for n beams, then update() every frame.
+ */
+template<typename F>
+struct lb_lrf_motion_detector_t {
+    lb_lrf_motion_configuration cfg;
+    F angle_start;                              //!< angle of the first beam
+    F angle_res;                                //!< angle between beams (negative if clockwise)
+    size_t n;                                   //!< number of beams
+
+    std::vector<std::vector<vec2<F> > > history;//!< previous scans in world coordinate (ring)
+    size_t head;                                //!< next history slot
+    size_t n_frame;                             //!< number of stored scans
+    std::vector<F> free_range;                  //!< free range of each beam from the background
+    std::vector<F> zbuf;                        //!< z-buffer of one background scan
+    std::vector<vec2<F> > local;                //!< background scan in the current sensor frame
+
+    lb_lrf_motion_detector_t() : angle_start(0), angle_res(0), n(0), head(0), n_frame(0) { }
+
+    /**
+     * Setup the detector and allocate all buffers.
+     * @param _cfg configuration
+     * @param start angle of the first beam (point order)
+     * @param end angle of the last beam
+     * @param _n number of beams
+     */
+    void setup(const lb_lrf_motion_configuration& _cfg,
+               const LB_FLOAT start,
+               const LB_FLOAT end,
+               const size_t _n)
+    {
+        if((_n < 2) || (_cfg.n_history < 1)) {
+            throw LibRoboticsRuntimeException("%s: invalid beam or history size", __FUNCTION__);
+        }
+        cfg = _cfg;
+        n = _n;
+        angle_start = (F)start;
+        angle_res = (F)((end - start) / (n - 1));
+        history.resize(cfg.n_history);
+        for(size_t h = 0; h < history.size(); h++) {
+            history[h].reserve(n);
+        }
+        free_range.resize(n);
+        zbuf.resize(n);
+        local.resize(n);
+        reset();
+    }
+
+    ///Forget all previous scans
+    void reset() {
+        head = 0;
+        n_frame = 0;
+        for(size_t h = 0; h < history.size(); h++) {
+            history[h].clear();
+        }
+    }
+
+    ///Beam bin of a point in the sensor frame (-1 if outside the scan)
+    inline int get_bin(const vec2<F>& p) const {
+        F a = lb_math_approx::atan2(p.y, p.x) - angle_start;
+        if(angle_res < 0) a = -a;
+        a -= (F)(2.0 * M_PI) * floor(a * (F)(0.5 / M_PI));     //[0, 2pi)
+        int bin = (int)(a / fabs(angle_res) + (F)0.5);
+        return (bin < (int)n) ? bin : -1;
+    }
+
+    /**
+     * Detect moving returns of a scan, then add the scan to the background.
+     * @param z scan points in the sensor frame ((0, 0) if no return), n points
+     * @param sensor_pose sensor pose in world (odometry pose and sensor mount)
+     * @param mask condition mask of each point, LRF_COND_MOVE is set or cleared
+     * @return number of moving returns
+     */
+    size_t update(const std::vector<vec2<F> >& z,
+                  const rigid2<F>& sensor_pose,
+                  std::vector<unsigned char>& mask)
+    {
+        if((z.size() != n) || (mask.size() != n)) {
+            throw LibRoboticsRuntimeException("%s: scan size %d, mask size %d, expected %d", __FUNCTION__,
+                                              (int)z.size(), (int)mask.size(), (int)n);
+        }
+
+        //free range of each beam from the background scans
+        F unknown = 0;
+        for(size_t i = 0; i < n; i++) {
+            free_range[i] = unknown;
+        }
+        rigid2<F> to_sensor = sensor_pose.inverse();
+        for(size_t h = 0; h < n_frame; h++) {
+            const std::vector<vec2<F> >& w = history[h];
+            if(w.empty()) continue;
+            lb_rigid2_apply(to_sensor, &w[0], &local[0], w.size());
+
+            //polar z-buffer, nearest point of this scan
+            for(size_t i = 0; i < n; i++) {
+                zbuf[i] = (std::numeric_limits<F>::max)();
+            }
+            for(size_t i = 0; i < w.size(); i++) {
+                int bin = get_bin(local[i]);
+                if(bin < 0) continue;
+                F r = local[i].size();
+                zbuf[bin] = LB_MIN(zbuf[bin], r);
+            }
+
+            //free space of a beam is the nearest point of its neighbourhood
+            int k = cfg.neighbour;
+            for(int i = 0; i < (int)n; i++) {
+                F r = (std::numeric_limits<F>::max)();
+                int j0 = LB_MAX(0, i - k);
+                int j1 = LB_MIN((int)n - 1, i + k);
+                for(int j = j0; j <= j1; j++) {
+                    r = LB_MIN(r, zbuf[j]);
+                }
+                if(r < (std::numeric_limits<F>::max)()) {
+                    free_range[i] = LB_MAX(free_range[i], r);
+                }
+            }
+        }
+
+        //returns inside free space
+        size_t n_move = 0;
+        F max_r = (F)((cfg.max_range > 0) ? cfg.max_range : (std::numeric_limits<F>::max)());
+        for(size_t i = 0; i < n; i++) {
+            F r = z[i].size();
+            F b = free_range[i];
+            unsigned char move = (unsigned char)((r > 0) & (r <= max_r) & (b > 0) &
+                                                 (r < (b - (F)cfg.threshold - ((F)cfg.ratio * b))));
+            mask[i] = (unsigned char)((mask[i] & ~LRF_COND_MOVE) | (move * LRF_COND_MOVE));
+            n_move += move;
+        }
+
+        //store the scan in world coordinate
+        std::vector<vec2<F> >& w = history[head];
+        w.clear();
+        for(size_t i = 0; i < n; i++) {
+            if(z[i].is_zero()) continue;
+            w.push_back(sensor_pose.apply(z[i]));
+        }
+        head = (head + 1) % history.size();
+        n_frame = LB_MIN(n_frame + 1, history.size());
+        return n_move;
+    }
+
+    /**
+     * Detect moving returns with robot odometry and sensor mount.
+     * @param z scan points in the sensor frame
+     * @param robot_pose robot pose (odometry)
+     * @param local_offset sensor pose on the robot
+     * @param mask condition mask of each point
+     * @return number of moving returns
+     */
+    size_t update(const std::vector<vec2<F> >& z,
+                  const pose2f& robot_pose,
+                  const pose2f& local_offset,
+                  std::vector<unsigned char>& mask)
+    {
+        return update(z, rigid2<F>(robot_pose) * rigid2<F>(local_offset), mask);
+    }
+};
+
+typedef lb_lrf_motion_detector_t<LB_FLOAT> lb_lrf_motion_detector;
+
+/**
+ * Keep segments with moving returns, so detection and tracking can skip static structure.
+ * @param views segments
+ * @param mask condition mask of each point (LRF_COND_MOVE from lb_lrf_motion_detector_t)
+ * @param result segments with at least min_ratio moving points
+ * @param min_ratio minimum ratio of moving points
+ * @return number of moving segments
+ */
+inline size_t lb_lrf_get_moving_segment(const std::vector<lrf_segment_view>& views,
+                                        const std::vector<unsigned char>& mask,
+                                        std::vector<lrf_segment_view>& result,
+                                        const LB_FLOAT min_ratio = 0.5)
+{
+    result.clear();
+    for(size_t k = 0; k < views.size(); k++) {
+        const lrf_segment_view& v = views[k];
+        if(v.empty()) continue;
+        size_t n_move = 0;
+        for(int i = v.begin; i < v.end; i++) {
+            n_move += (mask[i] & LRF_COND_MOVE) ? 1 : 0;
+        }
+        if((n_move > 0) && (n_move >= min_ratio * v.size())) {
+            result.push_back(v);
+        }
+    }
+    return result.size();
+}
+
+}
+
+#endif /* LB_LRF_MOTION_DETECT_H_ */
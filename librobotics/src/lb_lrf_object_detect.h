@@ -34,6 +34,7 @@
 #include "lb_exception.h"
 #include "lb_data_type.h"
 #include "lb_regression.h"
+#include "lb_random.h"
 #include "lb_statistic_function.h"
 
 
@@ -41,14 +42,75 @@
 namespace librobotics {
 
 
-inline int lb_lrf_recusive_line_fitting(const std::vector<vec2f>& points,
-                                        std::vector<lrf_object>& objects,
-                                        const LB_FLOAT min_length,
-                                        const LB_FLOAT err_threshold,
-                                        const int id = -1,
-                                        const size_t min_point = 4)
+/**
+ * Copy points of objects added from segment views (objects[first...]) into
+ * lrf_object::points, for the detectors that take a whole point vector.
+ * @param points scan points
+ * @param objects object list
+ * @param first index of the first new object
+ */
+inline void lb_lrf_object_copy_points(const std::vector<vec2f>& points,
+                                      std::vector<lrf_object>& objects,
+                                      size_t first)
 {
-    size_t n = points.size();
+    for(size_t i = first; i < objects.size(); i++) {
+        if((objects[i].begin >= 0) && (objects[i].end > objects[i].begin)) {
+            objects[i].points.assign(points.begin() + objects[i].begin, points.begin() + objects[i].end);
+        }
+    }
+}
+
+///Set line parameters of a line object from regression result (y = mx + b, r max error)
+inline void lb_lrf_set_line_object(lrf_object_record& line,
+                                   const lrf_segment_view& view,
+                                   const LB_FLOAT m,
+                                   const LB_FLOAT b,
+                                   const LB_FLOAT r)
+{
+    LB_FLOAT theta=atan2(-1/m,1);
+
+    if ( ((m > 0) && (b >0)) || ((m < 0) && (b < 0)) ) {
+        theta =- (M_PI - theta);
+    };
+
+    LB_FLOAT rho = fabs(b/sqrt(LB_SQR(m*m)+1));
+    vec2f pt(rho*cos(theta), rho*sin(theta));
+
+    line.begin = view.begin;
+    line.end = view.end;
+    line.type = LRF_OBJ_LINE;
+    line.extra_point[0] = vec2f(cos(theta), sin(theta));    //line direction
+    line.extra_point[1] = pt;                                 //vector to line normal
+    line.extra_param[0] = m;
+    line.extra_param[1] = b;
+    line.extra_param[2] = r;
+    line.segment_id = view.id;
+}
+
+/**
+ * One step of split line fitting: fit a line to the view, or find where to split it.
+ * @param points scan points
+ * @param view segment in points
+ * @param line result line (if 1 is returned)
+ * @param n_break split position in the view (if 2 is returned)
+ * @param min_length minimum line length
+ * @param err_threshold maximum point to line distance
+ * @param min_point minimum points of a line
+ * @param moments moment table for O(1) line fit (optional)
+ * @param moment_begin index in points of the first point of the moment table
+ * @return 0 rejected, 1 line, 2 split
+ */
+inline int lb_lrf_line_fit_or_split(const std::vector<vec2f>& points,
+                                    const lrf_segment_view& view,
+                                    lrf_object_record& line,
+                                    size_t& n_break,
+                                    const LB_FLOAT min_length,
+                                    const LB_FLOAT err_threshold,
+                                    const size_t min_point,
+                                    const lb_line_moment_table<LB_FLOAT>* moments = NULL,
+                                    const size_t moment_begin = 0)
+{
+    size_t n = view.size();
 
     //check total point
     if(n < min_point) {
@@ -56,14 +118,21 @@ inline int lb_lrf_recusive_line_fitting(const std::vector<vec2f>& points,
         return 0;
     }
 
+    const vec2f* p = &points[view.begin];
+
     //check length (simple)
-    if((points[0] - points[n - 1]).size() < min_length) {
+    if((p[0] - p[n - 1]).size() < min_length) {
         debug("%s: not enough length", __FUNCTION__);
         return 0;
     }
 
     LB_FLOAT m = 0, b = 0, r = 0;
-    lb_liner_regression(points, m, b, r);
+    if(moments) {
+        lb_liner_regression(*moments, &points[moment_begin],
+                            view.begin - moment_begin, view.end - moment_begin, m, b, r);
+    } else {
+        lb_liner_regression(p, n, m, b, r);
+    }
 
     //check result
     if(m == 0 && b == 0 && r == 0) {
@@ -72,78 +141,591 @@ inline int lb_lrf_recusive_line_fitting(const std::vector<vec2f>& points,
     }
 
     if(r < err_threshold) {
-        //LB_PRINT_VAL("single line");
-        LB_FLOAT theta=atan2(-1/m,1);
+        lb_lrf_set_line_object(line, view, m, b, r);
+        return 1;
+    }
 
-        if ( ((m > 0) && (b >0)) || ((m < 0) && (b < 0)) ) {
-            theta =- (M_PI - theta);
-        };
+    LB_FLOAT A = 0, B = 0, C = 0, ss = 0;
+    lb_line_define(p, n, A, B, C);
+    ss = LB_SIZE(A, B);
+
+    // search for lines break
+    n_break = 0;
+    LB_FLOAT dist, dist_max = -1.0;
+    for (size_t i = 0; i < n; i++) {
+        dist = fabs( (p[i].x*A + p[i].y*B + C)/ss);
+        if (dist > dist_max) {
+            dist_max = dist;
+            n_break = i;
+        }
+    }
+
+    return (dist_max > err_threshold) ? 2 : 0;
+}
 
-        LB_FLOAT rho = fabs(b/sqrt(LB_SQR(m*m)+1));
-        vec2f p(rho*cos(theta), rho*sin(theta));
+/**
+ * Recursive line fitting (split) of a segment.
+ * Objects refer to the points by lrf_object::begin/end, points are not copied.
+ * @param points scan points
+ * @param view segment in points
+ * @param objects output objects (std::vector<lrf_object> or lrf_object_arena)
+ * @param min_length minimum line length
+ * @param err_threshold maximum point to line distance
+ * @param min_point minimum points of a line
+ * @return number of lines
+ */
+template<typename O>
+inline int lb_lrf_recusive_line_fitting(const std::vector<vec2f>& points,
+                                        const lrf_segment_view& view,
+                                        O& objects,
+                                        const LB_FLOAT min_length,
+                                        const LB_FLOAT err_threshold,
+                                        const size_t min_point = 4)
+{
+    lrf_object_record line;
+    size_t n_break = 0;
+    int res = lb_lrf_line_fit_or_split(points, view, line, n_break, min_length, err_threshold, min_point);
 
+    if(res == 1) {
         //add line
-        lrf_object line;
-        line.points = points;
-        line.type = LRF_OBJ_LINE;
-        line.extra_point[0] = vec2f(cos(theta), sin(theta));    //line direction
-        line.extra_point[1] = p;                                  //vector to line normal
-        line.extra_param[0] = m;
-        line.extra_param[1] = b;
-        line.extra_param[2] = r;
-        line.segment_id = id;
         objects.push_back(line);
         return 1;
-    } else {
-        //LB_PRINT_VAL("recursive check");
-        LB_FLOAT A = 0, B = 0, C = 0, ss = 0;
-        lb_line_define(points, A, B, C);
-        ss = LB_SIZE(A, B);
-
-        // search for lines break
-        size_t n_break = 0;
-        LB_FLOAT dist, dist_max = -1.0;
-        for (size_t i = 0; i < n; i++) {
-            dist = fabs( (points[i].x*A + points[i].y*B + C)/ss);
-            if (dist > dist_max) {
-                dist_max = dist;
-                n_break = i;
+    }
+
+    if(res == 2) {
+        //First half
+        int line1 = lb_lrf_recusive_line_fitting(points,
+                                                 lrf_segment_view(view.begin, view.begin + n_break, view.id),
+                                                 objects,
+                                                 min_length,
+                                                 err_threshold,
+                                                 min_point);
+
+        //Second half
+        int line2 = lb_lrf_recusive_line_fitting(points,
+                                                 lrf_segment_view(view.begin + n_break, view.end, view.id),
+                                                 objects,
+                                                 min_length,
+                                                 err_threshold,
+                                                 min_point);
+        return line1 + line2;
+    }
+
+    return 0;
+}
+
+inline int lb_lrf_recusive_line_fitting(const std::vector<vec2f>& points,
+                                        std::vector<lrf_object>& objects,
+                                        const LB_FLOAT min_length,
+                                        const LB_FLOAT err_threshold,
+                                        const int id = -1,
+                                        const size_t min_point = 4)
+{
+    size_t first = objects.size();
+    int n_line = lb_lrf_recusive_line_fitting(points,
+                                              lrf_segment_view(0, points.size(), id),
+                                              objects,
+                                              min_length,
+                                              err_threshold,
+                                              min_point);
+    lb_lrf_object_copy_points(points, objects, first);
+    return n_line;
+}
+
+/**
+ * State of lb_lrf_split_and_merge() for one segment: the index ranges still to be
+ * split, the lines found so far (merged in place) and the moment table of the segment.
+ */
+struct lb_lrf_line_workspace {
+    std::vector<lrf_segment_view> stack;    //!< ranges to check
+    std::vector<lrf_object_record> lines;   //!< lines of the current segment
+    lb_line_moment_table<LB_FLOAT> moments; //!< moments of the current segment
+};
+
+/**
+ * Iterative split-and-merge line extraction of a segment.
+ * Split is the same as lb_lrf_recusive_line_fitting() (same order), but with an explicit
+ * stack of index ranges and line fits from a moment table of the segment (O(1) per range).
+ * With merge, neighbouring lines (end of one is begin of the next) are merged while the
+ * merged line still fits within err_threshold.
+ * Objects refer to the points by lrf_object::begin/end.
+ * @param points scan points
+ * @param view segment in points
+ * @param objects output objects (lrf_object_arena, or std::vector<lrf_object> with points copied)
+ * @param min_length minimum line length
+ * @param err_threshold maximum point to line distance
+ * @param ws workspace
+ * @param merge merge collinear neighbouring lines
+ * @param min_point minimum points of a line
+ * @return number of lines
+ */
+template<typename O>
+inline int lb_lrf_split_and_merge(const std::vector<vec2f>& points,
+                                  const lrf_segment_view& view,
+                                  O& objects,
+                                  const LB_FLOAT min_length,
+                                  const LB_FLOAT err_threshold,
+                                  lb_lrf_line_workspace& ws,
+                                  const bool merge = true,
+                                  const size_t min_point = 4)
+{
+    ws.stack.clear();
+    ws.lines.clear();
+    if(view.empty()) return 0;
+
+    ws.moments.build(&points[view.begin], view.size());
+    ws.stack.push_back(view);
+
+    //split, the first half is on top of the stack (same order as recursion)
+    lrf_object_record line;
+    size_t n_break = 0;
+    while(!ws.stack.empty()) {
+        lrf_segment_view v = ws.stack.back();
+        ws.stack.pop_back();
+
+        int res = lb_lrf_line_fit_or_split(points, v, line, n_break, min_length, err_threshold, min_point,
+                                           &ws.moments, view.begin);
+        if(res == 1) {
+            ws.lines.push_back(line);
+        } else if(res == 2) {
+            ws.stack.push_back(lrf_segment_view(v.begin + n_break, v.end, v.id));
+            ws.stack.push_back(lrf_segment_view(v.begin, v.begin + n_break, v.id));
+        }
+    }
+
+    //merge
+    if(merge && (ws.lines.size() > 1)) {
+        size_t k = 0;
+        LB_FLOAT m = 0, b = 0, r = 0;
+        for(size_t i = 1; i < ws.lines.size(); i++) {
+            lrf_object_record& last = ws.lines[k];
+            const lrf_object_record& next = ws.lines[i];
+            if(last.end == next.begin) {
+                lrf_segment_view v(last.begin, next.end, view.id);
+                lb_liner_regression(ws.moments, &points[view.begin],
+                                    v.begin - view.begin, v.end - view.begin, m, b, r);
+                if(!(m == 0 && b == 0 && r == 0) && (r < err_threshold)) {
+                    lb_lrf_set_line_object(last, v, m, b, r);
+                    continue;
+                }
+            }
+            if(++k != i) ws.lines[k] = next;
+        }
+        ws.lines.resize(k + 1);
+    }
+
+    for(size_t i = 0; i < ws.lines.size(); i++) {
+        objects.push_back(ws.lines[i]);
+    }
+    return (int)ws.lines.size();
+}
+
+inline int lb_lrf_split_and_merge(const std::vector<vec2f>& points,
+                                  const lrf_segment_view& view,
+                                  std::vector<lrf_object>& objects,
+                                  const LB_FLOAT min_length,
+                                  const LB_FLOAT err_threshold,
+                                  lb_lrf_line_workspace& ws,
+                                  const bool merge = true,
+                                  const size_t min_point = 4)
+{
+    size_t first = objects.size();
+    int n_line = lb_lrf_split_and_merge<std::vector<lrf_object> >(points, view, objects, min_length,
+                                                                  err_threshold, ws, merge, min_point);
+    lb_lrf_object_copy_points(points, objects, first);
+    return n_line;
+}
+
+///Order objects by their first point in the scan
+inline bool lb_lrf_object_begin_compare(const lrf_object_record& i, const lrf_object_record& j) {
+    return i.begin < j.begin;
+}
+
+/**
+ * Configuration of RANSAC line extraction, distances are in point unit.
+ */
+struct lb_lrf_ransac_configuration {
+    LB_FLOAT inlier_threshold;      //!< maximum point to line distance of an inlier
+    LB_FLOAT min_length;            //!< minimum line length
+    LB_FLOAT max_gap;               //!< maximum distance between neighbouring inliers of a line
+    size_t min_point;               //!< minimum inliers of a line
+    size_t max_line;                //!< maximum lines of one call
+    size_t max_iteration;           //!< maximum hypotheses of one line
+    size_t sample_window;           //!< second sample point within this many points of the first (0 any)
+    LB_FLOAT confidence;            //!< stop sampling when an outlier free sample is this probable
+    boost::uint64_t seed;           //!< random seed, the same input gives the same lines
+
+    lb_lrf_ransac_configuration() :
+        inlier_threshold(0.03),
+        min_length(0.1),
+        max_gap(0.2),
+        min_point(5),
+        max_line(32),
+        max_iteration(200),
+        sample_window(20),
+        confidence(0.99),
+        seed(0x5EED)
+    { }
+};
+
+/**
+ * State of lb_lrf_ransac_line_detect(): the random engine (seeded from the configuration
+ * on every call), the points not yet taken by a line in SoA form with their scan index,
+ * the inlier flags of the best hypothesis, the spans of found lines and the points of
+ * the line being refit.
+ */
+struct lb_lrf_ransac_workspace {
+    lb_rng rng;
+    std::vector<LB_FLOAT> x, y;             //!< remaining points (SoA)
+    std::vector<int> index;                 //!< scan index of remaining points
+    std::vector<unsigned char> inlier;      //!< inlier flag of the best hypothesis
+    std::vector<unsigned char> taken;       //!< scan points in the span of a line (view index)
+    std::vector<vec2f> fit;                 //!< points of the accepted line
+    std::vector<lrf_object_record> lines;   //!< lines of the current call
+};
+
+/**
+ * Count inliers of 4 line hypotheses (nx*x + ny*y + c = 0, unit normal) in one pass.
+ * Branch free over SoA points, so the loop vectorizes.
+ */
+inline void lb_lrf_ransac_score4(const LB_FLOAT* x,
+                                 const LB_FLOAT* y,
+                                 size_t n,
+                                 const LB_FLOAT* nx,
+                                 const LB_FLOAT* ny,
+                                 const LB_FLOAT* c,
+                                 const LB_FLOAT threshold,
+                                 size_t* count)
+{
+    const LB_FLOAT ax = nx[0], bx = nx[1], cx = nx[2], dx = nx[3];
+    const LB_FLOAT ay = ny[0], by = ny[1], cy = ny[2], dy = ny[3];
+    const LB_FLOAT ac = c[0], bc = c[1], cc = c[2], dc = c[3];
+    //floating point counters, exact up to 2^24 points and keep the loop in one vector type
+    LB_FLOAT c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    for(size_t i = 0; i < n; i++) {
+        const LB_FLOAT xi = x[i], yi = y[i];
+        c0 += (fabs(ax*xi + ay*yi + ac) < threshold) ? 1 : 0;
+        c1 += (fabs(bx*xi + by*yi + bc) < threshold) ? 1 : 0;
+        c2 += (fabs(cx*xi + cy*yi + cc) < threshold) ? 1 : 0;
+        c3 += (fabs(dx*xi + dy*yi + dc) < threshold) ? 1 : 0;
+    }
+    count[0] = (size_t)c0; count[1] = (size_t)c1; count[2] = (size_t)c2; count[3] = (size_t)c3;
+}
+
+/**
+ * RANSAC line extraction of a segment (or a whole scan as one view), for cluttered scans
+ * where split fitting breaks lines at every outlier.
+ * Hypotheses from two sample points are scored in batches of 4 over all remaining points.
+ * Sampling stops early once the best inlier ratio makes an outlier free sample likely
+ * (cfg.confidence). The inliers of the best hypothesis are cut into runs at gaps
+ * (cfg.max_gap) and at the spans of earlier lines, the inliers of the longest run are refit
+ * by lb_liner_regression(). If no run has cfg.min_point inliers, the inliers of the
+ * hypothesis are dropped and sampling goes on with the other points.
+ * Lines are output in scan order (lrf_object::begin/end).
+ * begin/end span the first to the last inlier of a line, spans of lines do not overlap.
+ * Outliers inside a span (clutter in front of a wall) are not used in the fit and are not
+ * given to later lines.
+ * @param points scan points
+ * @param view segment in points
+ * @param objects output objects (lrf_object_arena, or std::vector<lrf_object> with points copied)
+ * @param cfg configuration
+ * @param ws workspace
+ * @return number of lines
+ */
+template<typename O>
+inline int lb_lrf_ransac_line_detect(const std::vector<vec2f>& points,
+                                     const lrf_segment_view& view,
+                                     O& objects,
+                                     const lb_lrf_ransac_configuration& cfg,
+                                     lb_lrf_ransac_workspace& ws)
+{
+    ws.lines.clear();
+    ws.rng.seed(cfg.seed);
+
+    size_t n = 0;
+    ws.x.resize(view.size());
+    ws.y.resize(view.size());
+    ws.index.resize(view.size());
+    ws.inlier.resize(view.size());
+    ws.taken.assign(view.size(), 0);
+    for(int i = view.begin; i < view.end; i++) {
+        if(points[i].x == 0 && points[i].y == 0) continue;   //no return
+        ws.x[n] = points[i].x;
+        ws.y[n] = points[i].y;
+        ws.index[n] = i;
+        n++;
+    }
+
+    const size_t min_point = LB_MAX(cfg.min_point, (size_t)2);
+    const double log_fail = log(1.0 - LB_MIN(cfg.confidence, (LB_FLOAT)0.999999));
+
+    while((ws.lines.size() < cfg.max_line) && (n >= min_point)) {
+        LB_FLOAT* x = &ws.x[0];
+        LB_FLOAT* y = &ws.y[0];
+
+        //sample and score
+        LB_FLOAT best[3] = { 0, 0, 0 };
+        size_t best_count = 0;
+        size_t max_iteration = cfg.max_iteration;
+        for(size_t it = 0; it < max_iteration; it += 4) {
+            LB_FLOAT nx[4], ny[4], c[4];
+            size_t count[4];
+            for(int k = 0; k < 4; k++) {
+                size_t i = (size_t)(ws.rng.uniform() * n);
+                size_t j;
+                if(cfg.sample_window > 0) {
+                    size_t w = LB_MIN(cfg.sample_window, n - 1);
+                    size_t d = 1 + (size_t)(ws.rng.uniform() * w);
+                    j = (i + d < n) ? i + d : ((i >= d) ? i - d : n - 1);
+                } else {
+                    j = (size_t)(ws.rng.uniform() * (n - 1));
+                    if(j >= i) j++;
+                }
+                LB_FLOAT dx = x[j] - x[i];
+                LB_FLOAT dy = y[j] - y[i];
+                LB_FLOAT s = sqrt(dx*dx + dy*dy);
+                if(s < cfg.inlier_threshold) {
+                    //degenerate sample, no inlier
+                    nx[k] = ny[k] = 0; c[k] = -2 * cfg.inlier_threshold;
+                } else {
+                    nx[k] = -dy / s; ny[k] = dx / s;
+                    c[k] = -(nx[k]*x[i] + ny[k]*y[i]);
+                }
+            }
+            lb_lrf_ransac_score4(x, y, n, nx, ny, c, cfg.inlier_threshold, count);
+            for(int k = 0; k < 4; k++) {
+                if(count[k] > best_count) {
+                    best_count = count[k];
+                    best[0] = nx[k]; best[1] = ny[k]; best[2] = c[k];
+                }
+            }
+
+            //early termination
+            LB_FLOAT w = (LB_FLOAT)best_count / n;
+            if(w >= 1) break;
+            if(w > 0) {
+                double need = log_fail / log(1.0 - w*w);
+                if(need < max_iteration) max_iteration = (size_t)need + 1;
             }
         }
+        if(best_count < min_point) break;
 
-        if (dist_max > err_threshold) {
-            //First half
-            std::vector<vec2f> first_beam;
-            for(size_t i = 0; i < n_break; i++) {
-                first_beam.push_back(points[i]);
+        //longest run of inliers, cut at gaps and at spans of earlier lines
+        const LB_FLOAT gap2 = LB_SQR(cfg.max_gap);
+        size_t run_begin = 0, run_end = 0, run_n = 0, cur_begin = 0, cur_n = 0, last = 0;
+        for(size_t i = 0; i < n; i++) {
+            ws.inlier[i] = (fabs(best[0]*x[i] + best[1]*y[i] + best[2]) < cfg.inlier_threshold);
+            if(!ws.inlier[i]) continue;
+            if(cur_n > 0) {
+                bool cut = (LB_SQR(x[i] - x[last]) + LB_SQR(y[i] - y[last]) > gap2);
+                for(int j = ws.index[last] + 1; !cut && (j < ws.index[i]); j++) {
+                    cut = (ws.taken[j - view.begin] != 0);
+                }
+                if(cut) cur_n = 0;
+            }
+            if(cur_n == 0) cur_begin = i;
+            cur_n++;
+            last = i;
+            if(cur_n > run_n) {
+                run_n = cur_n;
+                run_begin = cur_begin;
+                run_end = i + 1;
             }
-            int line1 = lb_lrf_recusive_line_fitting(first_beam,
-                                                     objects,
-                                                     min_length,
-                                                     err_threshold,
-                                                     min_point);
-
-            //Second half
-            std::vector<vec2f> second_beam;
-            for(size_t i = n_break; i < n; i++) {
-                second_beam.push_back(points[i]);
+        }
+
+        if(run_n < min_point) {
+            //inliers are scattered, drop them so the next hypothesis differs
+            debug("%s: no run of %d inliers", __FUNCTION__, (int)min_point);
+            size_t k = 0;
+            for(size_t i = 0; i < n; i++) {
+                if(ws.inlier[i]) continue;
+                x[k] = x[i];
+                y[k] = y[i];
+                ws.index[k] = ws.index[i];
+                k++;
             }
+            n = k;
+            continue;
+        }
 
-            int line2 = lb_lrf_recusive_line_fitting(second_beam,
-                                                     objects,
-                                                     min_length,
-                                                     err_threshold,
-                                                     min_point);
-            return line1 + line2;
-        }//if
-    }//if
+        //refit the inliers of the run, remove all points of its span
+        ws.fit.clear();
+        for(size_t i = run_begin; i < run_end; i++) {
+            if(ws.inlier[i]) ws.fit.push_back(vec2f(x[i], y[i]));
+        }
+        lrf_segment_view v(ws.index[run_begin], ws.index[run_end - 1] + 1, view.id);
+
+        size_t k = run_begin;
+        for(size_t i = run_end; i < n; i++) {
+            x[k] = x[i];
+            y[k] = y[i];
+            ws.index[k] = ws.index[i];
+            k++;
+        }
+        n = k;
 
-    return 0;
+        if((ws.fit.front() - ws.fit.back()).size() < cfg.min_length) {
+            debug("%s: not enough length", __FUNCTION__);
+            continue;
+        }
+
+        LB_FLOAT m = 0, b = 0, r = 0;
+        lb_liner_regression(&ws.fit[0], ws.fit.size(), m, b, r);
+
+        lrf_object_record line;
+        lb_lrf_set_line_object(line, v, m, b, r);
+        ws.lines.push_back(line);
+        std::fill(ws.taken.begin() + (v.begin - view.begin), ws.taken.begin() + (v.end - view.begin), 1);
+    }
+
+    std::sort(ws.lines.begin(), ws.lines.end(), lb_lrf_object_begin_compare);
+    for(size_t i = 0; i < ws.lines.size(); i++) {
+        objects.push_back(ws.lines[i]);
+    }
+    return (int)ws.lines.size();
+}
+
+inline int lb_lrf_ransac_line_detect(const std::vector<vec2f>& points,
+                                     const lrf_segment_view& view,
+                                     std::vector<lrf_object>& objects,
+                                     const lb_lrf_ransac_configuration& cfg,
+                                     lb_lrf_ransac_workspace& ws)
+{
+    size_t first = objects.size();
+    int n_line = lb_lrf_ransac_line_detect<std::vector<lrf_object> >(points, view, objects, cfg, ws);
+    lb_lrf_object_copy_points(points, objects, first);
+    return n_line;
+}
+
+/**
+ * End points of a line object, the first and last point of the line projected on it.
+ * @param points scan points
+ * @param line line object (lrf_object::begin/end)
+ * @param p0 first end point
+ * @param p1 last end point
+ */
+inline void lb_lrf_line_end_point(const std::vector<vec2f>& points,
+                                  const lrf_object_record& line,
+                                  vec2f& p0,
+                                  vec2f& p1)
+{
+    //normal of mx - y + b = 0
+    const LB_FLOAT m = line.extra_param[0];
+    const LB_FLOAT b = line.extra_param[1];
+    const LB_FLOAT s = 1 / (m*m + 1);
+    const vec2f& a = points[line.begin];
+    const vec2f& e = points[line.end - 1];
+    LB_FLOAT da = (m*a.x - a.y + b) * s;
+    LB_FLOAT de = (m*e.x - e.y + b) * s;
+    p0 = vec2f(a.x - da*m, a.y + da);
+    p1 = vec2f(e.x - de*m, e.y + de);
+}
+
+/**
+ * Corner detection from lines in scan order (lb_lrf_split_and_merge(), lb_lrf_ransac_line_detect()).
+ * Two neighbouring lines make a corner if the end points that face each other are within
+ * max_distance of the line intersection, and the angle between the lines is in [min_angle, max_angle].
+ * Corner object: extra_point[0] position, extra_point[1] and [2] unit direction of the first
+ * and second line away from the corner, extra_param[0] angle between the lines, extra_param[1]
+ * direction of the bisector, extra_param[2] larger end point distance to the corner,
+ * begin/end cover both lines.
+ * @param points scan points
+ * @param lines lines in scan order
+ * @param objects output objects (lrf_object_arena, or std::vector<lrf_object> with points copied)
+ * @param max_distance maximum distance from end points to the corner
+ * @param min_angle minimum angle between lines
+ * @param max_angle maximum angle between lines
+ * @return number of corners
+ */
+template<typename L, typename O>
+inline int lb_lrf_corner_detect(const std::vector<vec2f>& points,
+                                const L& lines,
+                                O& objects,
+                                const LB_FLOAT max_distance,
+                                const LB_FLOAT min_angle = LB_DEG2RAD(45.0),
+                                const LB_FLOAT max_angle = LB_DEG2RAD(135.0))
+{
+    //lines and objects can be the same container, keep a copy of the previous line
+    int n_corner = 0;
+    const size_t n = lines.size();
+    lrf_object_record prev;
+    bool has_prev = false;
+    vec2f a0, a1, b0, b1;
+    for(size_t i = 0; i < n; i++) {
+        const lrf_object_record line = lines[i];
+        if((line.type != LRF_OBJ_LINE) || (line.begin < 0) || (line.end <= line.begin)) continue;
+        if(has_prev && (line.end <= prev.end)) continue;   //inside the previous line (clutter)
+        lb_lrf_line_end_point(points, line, b0, b1);
+        if(!has_prev) {
+            prev = line;
+            has_prev = true;
+            a0 = b0; a1 = b1;
+            continue;
+        }
+
+        const LB_FLOAT m1 = prev.extra_param[0], c1 = prev.extra_param[1];
+        const LB_FLOAT m2 = line.extra_param[0], c2 = line.extra_param[1];
+        if(fabs(m1 - m2) > 1e-6) {
+            vec2f c;
+            c.x = (c2 - c1) / (m1 - m2);
+            c.y = m1 * c.x + c1;
+
+            LB_FLOAT da = (a1 - c).size();
+            LB_FLOAT db = (b0 - c).size();
+            vec2f u = a0 - c;
+            vec2f v = b1 - c;
+            LB_FLOAT su = u.size();
+            LB_FLOAT sv = v.size();
+            if((da < max_distance) && (db < max_distance) && (su > 0) && (sv > 0)) {
+                u = u / su;
+                v = v / sv;
+                LB_FLOAT angle = acos(LB_MAX((LB_FLOAT)-1, LB_MIN((LB_FLOAT)1, u.x*v.x + u.y*v.y)));
+                if((angle >= min_angle) && (angle <= max_angle)) {
+                    lrf_object_record corner;
+                    corner.type = LRF_OBJ_CORNER;
+                    corner.begin = prev.begin;
+                    corner.end = line.end;
+                    corner.segment_id = line.segment_id;
+                    corner.extra_point[0] = c;
+                    corner.extra_point[1] = u;
+                    corner.extra_point[2] = v;
+                    corner.extra_param[0] = angle;
+                    corner.extra_param[1] = atan2(u.y + v.y, u.x + v.x);
+                    corner.extra_param[2] = LB_MAX(da, db);
+                    objects.push_back(corner);
+                    n_corner++;
+                }
+            }
+        }
+        prev = line;
+        a0 = b0; a1 = b1;
+    }
+    return n_corner;
 }
 
+template<typename L>
+inline int lb_lrf_corner_detect(const std::vector<vec2f>& points,
+                                const L& lines,
+                                std::vector<lrf_object>& objects,
+                                const LB_FLOAT max_distance,
+                                const LB_FLOAT min_angle = LB_DEG2RAD(45.0),
+                                const LB_FLOAT max_angle = LB_DEG2RAD(135.0))
+{
+    size_t first = objects.size();
+    int n_corner = lb_lrf_corner_detect<L, std::vector<lrf_object> >(points, lines, objects, max_distance,
+                                                                     min_angle, max_angle);
+    lb_lrf_object_copy_points(points, objects, first);
+    return n_corner;
+}
 
+/**
+ * Arc detection of a segment.
+ * The object refers to the points by lrf_object::begin/end, points are not copied.
+ */
+template<typename O>
 inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
-                              std::vector<lrf_object>& objects,
+                              const lrf_segment_view& view,
+                              O& objects,
                               const LB_FLOAT min_angle,
                               const LB_FLOAT max_angle,
                               const LB_FLOAT max_stdev,
@@ -152,18 +734,18 @@ inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
                               const LB_FLOAT is_line_stdev,
                               const LB_FLOAT min_diameter = -1,
                               const LB_FLOAT max_diameter = (std::numeric_limits<LB_FLOAT>::max)(),
-                              const int id = -1,
                               const size_t min_point = 10)
 {
-    size_t n = points.size();
+    size_t n = view.size();
     if(n < min_point) {
         debug("%s: not enough point", __FUNCTION__);
         return false;
     }
 
-    vec2f middle = points[n >> 1];
-    vec2f right = points[0];
-    vec2f left = points[n - 1];
+    const vec2f* p = &points[view.begin];
+    vec2f middle = p[n >> 1];
+    vec2f right = p[0];
+    vec2f left = p[n - 1];
     vec2f center = (right + left) * 0.5;
 
 //    LB_PRINT_VAR(left);
@@ -199,22 +781,21 @@ inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
     }
 
 
+    // angle inside arc, mean and standard deviation in one pass (Welford)
     size_t n_angle = n - 3;
-    LB_FLOAT ma = 0, mb = 0;
-    std::vector<LB_FLOAT>angles(n_angle, 0);
-
-    // angle inside arc
+    LB_FLOAT ma = 0, mb = 0, angle, delta;
+    LB_FLOAT average = 0, sum_sqr = 0;
     vec2f xy_temp;
     for (size_t i = 0; i < n_angle; i++) {
-        xy_temp = points[i+1];
+        xy_temp = p[i+1];
         ma = (left - xy_temp).theta();
         mb = (right - xy_temp).theta();
-        angles[i] = fabs(lb_normalize_angle(ma - mb));
+        angle = fabs(lb_normalize_angle(ma - mb));
+        delta = angle - average;
+        average += delta / (i + 1);
+        sum_sqr += delta * (angle - average);
     }
-
-//    LB_PRINT_VEC(slopes);
-    LB_FLOAT average = lb_mean(angles);
-    LB_FLOAT std_dev = lb_stdev(angles, average);
+    LB_FLOAT std_dev = (n_angle < 2) ? 0 : sqrt(sum_sqr / (n_angle - 1));
 
 //    LB_PRINT_VAR(average);
 //    LB_PRINT_VAR(std_dev);
@@ -247,14 +828,15 @@ inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
         if((average >= min_angle) && (average <= max_angle)) {
 //            LB_PRINT_VAR(center);
 //            LB_PRINT_VAR(radius);
-            lrf_object arc;
-            arc.points = points;
+            lrf_object_record arc;
+            arc.begin = view.begin;
+            arc.end = view.end;
             arc.type = LRF_OBJ_ARC;
             arc.extra_point[0] = center;
             arc.extra_param[0] = radius;
             arc.extra_param[1] = average;
             arc.extra_param[2] = std_dev;
-            arc.segment_id = id;
+            arc.segment_id = view.id;
             objects.push_back(arc);
             return true;
         } else {
@@ -267,24 +849,52 @@ inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
     return false;
 }
 
+inline bool lb_lrf_arc_fiting(const std::vector<vec2f>& points,
+                              std::vector<lrf_object>& objects,
+                              const LB_FLOAT min_angle,
+                              const LB_FLOAT max_angle,
+                              const LB_FLOAT max_stdev,
+                              const LB_FLOAT arc_ratio,
+                              const LB_FLOAT is_line_error,
+                              const LB_FLOAT is_line_stdev,
+                              const LB_FLOAT min_diameter = -1,
+                              const LB_FLOAT max_diameter = (std::numeric_limits<LB_FLOAT>::max)(),
+                              const int id = -1,
+                              const size_t min_point = 10)
+{
+    size_t first = objects.size();
+    bool found = lb_lrf_arc_fiting(points, lrf_segment_view(0, points.size(), id), objects,
+                                   min_angle, max_angle, max_stdev, arc_ratio,
+                                   is_line_error, is_line_stdev, min_diameter, max_diameter,
+                                   min_point);
+    lb_lrf_object_copy_points(points, objects, first);
+    return found;
+}
+
+/**
+ * Leg detection of a segment (one leg, or two legs in one segment).
+ * Objects refer to the points by lrf_object::begin/end, points are not copied.
+ */
+template<typename O>
 inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
-                             std::vector<lrf_object>& objects,
+                             const lrf_segment_view& view,
+                             O& objects,
                              const LB_FLOAT min_size,
                              const LB_FLOAT max_size,
                              const LB_FLOAT leg_arc_ratio,
-                             const int id = -1,
                              const bool do_ratio_check = false,
                              const size_t min_points = 5)
 {
-    size_t n = points.size();
+    size_t n = view.size();
     if(n < min_points) {
         debug("%s: not enough point", __FUNCTION__);
         return 0;
     }
 
-    vec2f middle = points[n >> 1];
-    vec2f right = points[0];
-    vec2f left = points[n - 1];
+    const vec2f* p = &points[view.begin];
+    vec2f middle = p[n >> 1];
+    vec2f right = p[0];
+    vec2f left = p[n - 1];
     vec2f center = (right + left) * 0.5;
 
     LB_FLOAT dist_lr = (left - right).size();
@@ -309,12 +919,13 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
 
         if(check_ratio) {
 //            LB_PRINT_VAL("add 1 leg");
-            lrf_object leg;
+            lrf_object_record leg;
             leg.type = LRF_OBJ_LEG;
-            leg.points = points;
+            leg.begin = view.begin;
+            leg.end = view.end;
             leg.extra_point[0] = center;
             leg.extra_param[0] = dist_lr * 0.5; //radius
-            leg.segment_id = id;
+            leg.segment_id = view.id;
             objects.push_back(leg);
             return 1;
         } else {
@@ -325,7 +936,8 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
     } else {
 //        LB_PRINT_VAL("check 2 leg");
         int cnt = 0;
-        vec2f right_middle = points[n >> 2];
+        int half = view.begin + (n >> 1);
+        vec2f right_middle = p[n >> 2];
         vec2f right_center = (right + middle) * 0.5;
         LB_FLOAT dist_mr = (middle - right).size();
         LB_FLOAT dist_rm_rc = (right_middle - right_center).size();
@@ -334,14 +946,13 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
         check_ratio |= (!do_ratio_check);
         if(check_ratio) {
             //add right leg
-            lrf_object leg;
-            for(size_t i = 0; i < (n >> 1); i++) {
-                leg.points.push_back(points[i]);
-            }
+            lrf_object_record leg;
+            leg.begin = view.begin;
+            leg.end = half;
             leg.type = LRF_OBJ_LEG;
             leg.extra_point[0] = right_center;
             leg.extra_param[0] = dist_mr / 2; //radius
-            leg.segment_id = id;
+            leg.segment_id = view.id;
             objects.push_back(leg);
             cnt++;
         } else {
@@ -349,7 +960,7 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
         }
 
 
-        vec2f left_middle = points[(n >> 2) + (n >> 1)];
+        vec2f left_middle = p[(n >> 2) + (n >> 1)];
         vec2f left_center = (left + middle) * 0.5;
         LB_FLOAT dist_ml = (middle - left).size();
         LB_FLOAT dist_lm_lc = (left_middle - left_center).size();
@@ -358,14 +969,13 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
         check_ratio |= (!do_ratio_check);
         if(check_ratio) {
             //add left leg
-            lrf_object leg;
-            for(size_t i = (n >> 1); i < n; i++) {
-                leg.points.push_back(points[i]);
-            }
+            lrf_object_record leg;
+            leg.begin = half;
+            leg.end = view.end;
             leg.type = LRF_OBJ_LEG;
             leg.extra_point[0] = left_center;
             leg.extra_param[0] = dist_ml * 0.5; //radius
-            leg.segment_id = id;
+            leg.segment_id = view.id;
             objects.push_back(leg);
             cnt++;
         } else {
@@ -377,12 +987,13 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
             objects.pop_back();
             objects.pop_back();
 
-            lrf_object leg2;
-            leg2.points = points;
+            lrf_object_record leg2;
+            leg2.begin = view.begin;
+            leg2.end = view.end;
             leg2.type = LRF_OBJ_LEG2;
             leg2.extra_point[0] = center;
             leg2.extra_param[0] = dist_lr * 0.5;
-            leg2.segment_id = id;
+            leg2.segment_id = view.id;
             objects.push_back(leg2);
         }
         return cnt;
@@ -390,22 +1001,44 @@ inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
     return 0;
 }
 
+inline int lb_lrf_leg_detect(const std::vector<vec2f>& points,
+                             std::vector<lrf_object>& objects,
+                             const LB_FLOAT min_size,
+                             const LB_FLOAT max_size,
+                             const LB_FLOAT leg_arc_ratio,
+                             const int id = -1,
+                             const bool do_ratio_check = false,
+                             const size_t min_points = 5)
+{
+    size_t first = objects.size();
+    int cnt = lb_lrf_leg_detect(points, lrf_segment_view(0, points.size(), id), objects,
+                                min_size, max_size, leg_arc_ratio, do_ratio_check, min_points);
+    lb_lrf_object_copy_points(points, objects, first);
+    return cnt;
+}
+
+/**
+ * Group detection of a segment.
+ * The object refers to the points by lrf_object::begin/end, points are not copied.
+ */
+template<typename O>
 inline bool lb_lrf_group_detect(const std::vector<vec2f>& points,
-                                std::vector<lrf_object>& objects,
+                                const lrf_segment_view& view,
+                                O& objects,
                                 const LB_FLOAT min_size,
                                 const LB_FLOAT max_size,
-                                const int id = -1,
                                 const size_t min_points = 5)
 {
-    size_t n = points.size();
+    size_t n = view.size();
     if(n < min_points) {
         debug("%s: not enough point", __FUNCTION__);
         return false;
     }
 
-    vec2f middle = points[n >> 1];
-    vec2f right = points[0];
-    vec2f left = points[n - 1];
+    const vec2f* p = &points[view.begin];
+    vec2f middle = p[n >> 1];
+    vec2f right = p[0];
+    vec2f left = p[n - 1];
     vec2f center = (right + left) * 0.5;
 
     LB_FLOAT dist_lr = (left - right).size();
@@ -426,128 +1059,419 @@ inline bool lb_lrf_group_detect(const std::vector<vec2f>& points,
     LB_FLOAT sum_x = 0;
     LB_FLOAT sum_y = 0;
     for(size_t i = 0; i < n; i++) {
-        sum_x += points[i].x;
-        sum_y += points[i].y;
+        sum_x += p[i].x;
+        sum_y += p[i].y;
     }
     sum_x /= n;
     sum_y /= n;
 
-    lrf_object group;
-    group.points = points;
+    lrf_object_record group;
+    group.begin = view.begin;
+    group.end = view.end;
     group.type = LRF_OBJ_GROUP;
     group.extra_point[0] = vec2f(sum_x, sum_y);
     group.extra_param[0] = dist_max / 2; //radius
-    group.segment_id = id;
+    group.segment_id = view.id;
     objects.push_back(group);
 
     return true;
 }
 
-inline int lb_lrf_object_human_check(std::vector<lrf_object>& objects,
+inline bool lb_lrf_group_detect(const std::vector<vec2f>& points,
+                                std::vector<lrf_object>& objects,
+                                const LB_FLOAT min_size,
+                                const LB_FLOAT max_size,
+                                const int id = -1,
+                                const size_t min_points = 5)
+{
+    size_t first = objects.size();
+    bool found = lb_lrf_group_detect(points, lrf_segment_view(0, points.size(), id), objects,
+                                     min_size, max_size, min_points);
+    lb_lrf_object_copy_points(points, objects, first);
+    return found;
+}
+
+/**
+ * Index tables of lb_lrf_object_human_check(): legs and their grid cells, the grid hash
+ * (bucket heads and chains), candidate leg pairs, lines/arcs/groups sorted by segment id,
+ * and which objects make each new 1+1 leg human.
+ */
+struct lb_lrf_human_workspace {
+    struct pair {
+        LB_FLOAT dist;
+        int a, b;
+        bool operator<(const pair& p) const { return dist < p.dist; }
+    };
+    struct human_leg {
+        int index, a, b;
+    };
+    struct segment_object {
+        int segment_id, index;
+        bool operator<(const segment_object& s) const { return segment_id < s.segment_id; }
+    };
+
+    std::vector<int> leg;                   //!< object index of legs
+    std::vector<int> cell_x, cell_y;        //!< grid cell of legs
+    std::vector<int> head;                  //!< grid hash, first leg of a bucket (-1 none)
+    std::vector<int> next;                  //!< next leg in the same bucket
+    std::vector<int> match;                 //!< paired leg (-1 orphan)
+    std::vector<pair> candidate;            //!< leg pairs within max_leg_distance
+    std::vector<segment_object> segment;    //!< lines, arcs and groups by segment id
+    std::vector<human_leg> human;           //!< object index of new 1+1 leg humans and their legs
+};
+
+/**
+ * Assemble humans from leg objects.
+ * - LRF_OBJ_LEG2 is a human.
+ * - Two LRF_OBJ_LEG closer than max_leg_distance are a human. Leg centers are indexed in a
+ *   grid hash (cell = max_leg_distance), so candidate pairs come from the 3x3 neighbour cells
+ *   only, and pairs are matched closest first (each leg in one human).
+ * - With allow_one_leg, an unpaired leg is checked against the lines, arcs and groups of its
+ *   segment (one sorted pass, not a scan of all objects per leg).
+ * Humans are appended to objects. A 1+1 leg human has extra_point[0] the center, extra_point[1]
+ * and [2] the leg centers, extra_param[0] the leg distance, begin/end cover both legs.
+ * @param objects objects (legs, lines, arcs, groups), humans are appended (std::vector<lrf_object> or lrf_object_arena)
+ * @param max_leg_distance maximum distance between legs of a human
+ * @param min_group_size minimum group size of a one leg human
+ * @param max_group_size maximum group size of a one leg human
+ * @param ws workspace
+ * @param allow_one_leg check unpaired legs
+ * @return number of humans
+ */
+template<typename O>
+inline int lb_lrf_object_human_check(O& objects,
                                      const LB_FLOAT max_leg_distance,
                                      const LB_FLOAT min_group_size,
                                      const LB_FLOAT max_group_size,
+                                     lb_lrf_human_workspace& ws,
                                      bool allow_one_leg = false)
 {
     size_t n = objects.size();
+    ws.human.clear();
 
     if(n == 0) return 0;
 
     int human_cnt = 0;
-    std::list<lrf_object> leg_object;
-    std::list<lrf_object>::iterator it;
-    LB_FLOAT leg_dist;
+    ws.leg.clear();
+    ws.segment.clear();
     for(size_t i = 0; i < n; i++) {
-        if(objects[i].type == LRF_OBJ_LEG2) {
-            //add human
-//            LB_PRINT_VAL("add 2 leg");
-            lrf_object human = objects[i];
+        switch(objects[i].type) {
+        case LRF_OBJ_LEG2: {
+            //add human (a copy, with the points of an lrf_object)
+            typename O::value_type human = objects[i];
             human.type = LRF_OBJ_HUMAN;
             objects.push_back(human);
             human_cnt++;
-        } else if(objects[i].type == LRF_OBJ_LEG) {
-            if(leg_object.size() > 0) {
-                //check current leg with leg_list
-                for (it = leg_object.begin(); it != leg_object.end(); it++) {
-                    //check distance
-                    leg_dist = ((*it).extra_point[0] - objects[i].extra_point[0]).size();
-                    if(leg_dist < max_leg_distance) {
-//                        LB_PRINT_VAL("add 1+1 leg");
-                        //add human
-                        lrf_object human;
-                        human.points = (*it).points;
-                        human.points.insert( human.points.end(),
-                                             objects[i].points.begin(),
-                                             objects[i].points.end());
-                        human.extra_point[0] =
-                            ((*it).extra_point[0] + objects[i].extra_point[0]) * 0.5;
-                        human.type = LRF_OBJ_HUMAN;
-                        objects.push_back(human);
-                        human_cnt++;
-
-
-                        //remove
-                        leg_object.erase(it);
-                        break;
-                    } else {
-//                        LB_PRINT_VAL("add new leg to the list");
-                        leg_object.push_back(objects[i]);
+            break;
+        }
+        case LRF_OBJ_LEG:
+            ws.leg.push_back((int)i);
+            break;
+        case LRF_OBJ_LINE:
+        case LRF_OBJ_ARC:
+        case LRF_OBJ_GROUP: {
+            lb_lrf_human_workspace::segment_object so;
+            so.segment_id = objects[i].segment_id;
+            so.index = (int)i;
+            ws.segment.push_back(so);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    const size_t n_leg = ws.leg.size();
+    if(n_leg == 0) return human_cnt;
+
+    //grid hash of leg centers
+    size_t n_bucket = 16;
+    while(n_bucket < 2 * n_leg) n_bucket <<= 1;
+    const size_t mask = n_bucket - 1;
+    const LB_FLOAT inv_cell = 1 / LB_MAX(max_leg_distance, (LB_FLOAT)1e-6);
+
+    ws.head.assign(n_bucket, -1);
+    ws.next.resize(n_leg);
+    ws.cell_x.resize(n_leg);
+    ws.cell_y.resize(n_leg);
+    ws.match.assign(n_leg, -1);
+    for(size_t k = 0; k < n_leg; k++) {
+        const vec2f& c = objects[ws.leg[k]].extra_point[0];
+        ws.cell_x[k] = (int)floor(c.x * inv_cell);
+        ws.cell_y[k] = (int)floor(c.y * inv_cell);
+        size_t h = ((size_t)ws.cell_x[k] * 73856093u ^ (size_t)ws.cell_y[k] * 19349663u) & mask;
+        ws.next[k] = ws.head[h];
+        ws.head[h] = (int)k;
+    }
+
+    //candidate pairs, each pair once (k < l)
+    ws.candidate.clear();
+    for(size_t k = 0; k < n_leg; k++) {
+        const vec2f& c = objects[ws.leg[k]].extra_point[0];
+        for(int dy = -1; dy <= 1; dy++) {
+            for(int dx = -1; dx <= 1; dx++) {
+                int cx = ws.cell_x[k] + dx;
+                int cy = ws.cell_y[k] + dy;
+                size_t h = ((size_t)cx * 73856093u ^ (size_t)cy * 19349663u) & mask;
+                for(int l = ws.head[h]; l >= 0; l = ws.next[l]) {
+                    //buckets are shared by hash collision, keep the legs of this cell only
+                    if((l <= (int)k) || (ws.cell_x[l] != cx) || (ws.cell_y[l] != cy)) continue;
+                    LB_FLOAT d = (objects[ws.leg[l]].extra_point[0] - c).size();
+                    if(d < max_leg_distance) {
+                        lb_lrf_human_workspace::pair p;
+                        p.dist = d;
+                        p.a = (int)k;
+                        p.b = l;
+                        ws.candidate.push_back(p);
                     }
                 }
-            } else {
-//                LB_PRINT_VAL("get 1st leg");
-                leg_object.push_back(objects[i]);
             }
         }
     }
 
+    //match closest first
+    std::sort(ws.candidate.begin(), ws.candidate.end());
+    for(size_t i = 0; i < ws.candidate.size(); i++) {
+        const lb_lrf_human_workspace::pair& p = ws.candidate[i];
+        if(ws.match[p.a] >= 0 || ws.match[p.b] >= 0) continue;
+        ws.match[p.a] = p.b;
+        ws.match[p.b] = p.a;
+
+        const lrf_object_record& la = objects[ws.leg[p.a]];
+        const lrf_object_record& lb = objects[ws.leg[p.b]];
+        lrf_object_record human;
+        human.type = LRF_OBJ_HUMAN;
+        human.extra_point[0] = (la.extra_point[0] + lb.extra_point[0]) * 0.5;
+        human.extra_point[1] = la.extra_point[0];
+        human.extra_point[2] = lb.extra_point[0];
+        human.extra_param[0] = p.dist;
+        human.segment_id = la.segment_id;
+        if(la.begin >= 0 && lb.begin >= 0) {
+            human.begin = LB_MIN(la.begin, lb.begin);
+            human.end = LB_MAX(la.end, lb.end);
+        }
+
+        lb_lrf_human_workspace::human_leg h;
+        h.index = (int)objects.size();
+        h.a = ws.leg[p.a];
+        h.b = ws.leg[p.b];
+        ws.human.push_back(h);
+
+        objects.push_back(human);
+        human_cnt++;
+    }
 
     //check all orphan leg
-    int pass = 0;
-    int group_idx = -1;
-    while(!leg_object.empty() && allow_one_leg) {
-        //check 1 leg condition
-        it = leg_object.begin();
-        pass = -10;
-        group_idx = -1;
-        for(size_t i = 0; i < n; i++) {
-            if(objects[i].segment_id == (*it).segment_id) {
-                switch(objects[i].type) {
-                case LRF_OBJ_LINE : pass--; break;
-                case LRF_OBJ_ARC : pass--; break;
-                case LRF_OBJ_GROUP :
-                    if(min_group_size <= objects[i].extra_param[0] &&
-                       max_group_size >= objects[i].extra_param[0])
+    if(allow_one_leg) {
+        std::sort(ws.segment.begin(), ws.segment.end());
+        for(size_t k = 0; k < n_leg; k++) {
+            if(ws.match[k] >= 0) continue;
+
+            lb_lrf_human_workspace::segment_object key;
+            key.segment_id = objects[ws.leg[k]].segment_id;
+            key.index = -1;
+            std::pair<std::vector<lb_lrf_human_workspace::segment_object>::const_iterator,
+                      std::vector<lb_lrf_human_workspace::segment_object>::const_iterator> range =
+                std::equal_range(ws.segment.begin(), ws.segment.end(), key);
+
+            //check 1 leg condition
+            int pass = -10;
+            int group_idx = -1;
+            for(; range.first != range.second; ++range.first) {
+                const lrf_object_record& o = objects[range.first->index];
+                if(o.type == LRF_OBJ_GROUP) {
+                    if(min_group_size <= o.extra_param[0] &&
+                       max_group_size >= o.extra_param[0])
                     {
                         pass++;
-                        group_idx = i;
+                        group_idx = LB_MAX(group_idx, range.first->index);
                     }
-                    break;
-                default:
-                    break;
+                } else {
+                    pass--;
                 }
             }
-        }
 
-        if(pass >= 2) {
-//            LB_PRINT_VAL("add 1 leg human");
-            if(group_idx == -1) {
-                lrf_object human = (*it);
-                human.type = LRF_OBJ_HUMAN;
-                objects.push_back(human);
-            } else {
-                lrf_object human = objects[group_idx];
+            if(pass >= 2) {
+                typename O::value_type human = objects[(group_idx == -1) ? ws.leg[k] : group_idx];
                 human.type = LRF_OBJ_HUMAN;
                 objects.push_back(human);
+                human_cnt++;
             }
-            human_cnt++;
         }
-        leg_object.pop_front();
     }
 
     return human_cnt;
 }
 
+inline int lb_lrf_object_human_check(std::vector<lrf_object>& objects,
+                                     const LB_FLOAT max_leg_distance,
+                                     const LB_FLOAT min_group_size,
+                                     const LB_FLOAT max_group_size,
+                                     bool allow_one_leg = false)
+{
+    lb_lrf_human_workspace ws;
+    int human_cnt = lb_lrf_object_human_check(objects, max_leg_distance, min_group_size, max_group_size,
+                                              ws, allow_one_leg);
+
+    //1+1 leg humans carry the points of both legs
+    for(size_t k = 0; k < ws.human.size(); k++) {
+        lrf_object& human = objects[ws.human[k].index];
+        const lrf_object& la = objects[ws.human[k].a];
+        const lrf_object& lb = objects[ws.human[k].b];
+        human.points = la.points;
+        human.points.insert(human.points.end(), lb.points.begin(), lb.points.end());
+    }
+    return human_cnt;
+}
+
+/**
+ * Configuration of lb_lrf_object_detector, parameters are those of the single detectors.
+ */
+struct lb_lrf_detect_configuration {
+    bool do_line;                   //!< lb_lrf_split_and_merge()
+    bool do_arc;                    //!< lb_lrf_arc_fiting()
+    bool do_leg;                    //!< lb_lrf_leg_detect()
+    bool do_group;                  //!< lb_lrf_group_detect()
+
+    LB_FLOAT line_min_length;
+    LB_FLOAT line_err_threshold;
+    bool line_merge;                //!< false gives the lines of lb_lrf_recusive_line_fitting()
+
+    LB_FLOAT arc_min_angle;
+    LB_FLOAT arc_max_angle;
+    LB_FLOAT arc_max_stdev;
+    LB_FLOAT arc_ratio;
+    LB_FLOAT arc_is_line_error;
+    LB_FLOAT arc_is_line_stdev;
+
+    LB_FLOAT leg_min_size;
+    LB_FLOAT leg_max_size;
+    LB_FLOAT leg_arc_ratio;
+    bool leg_ratio_check;
+
+    LB_FLOAT group_min_size;
+    LB_FLOAT group_max_size;
+
+    lb_lrf_detect_configuration() :
+        do_line(true), do_arc(true), do_leg(true), do_group(true),
+        line_min_length(0.2), line_err_threshold(0.1), line_merge(false),
+        arc_min_angle(1.57), arc_max_angle(2.8), arc_max_stdev(0.5),
+        arc_ratio(0.1), arc_is_line_error(0.1), arc_is_line_stdev(0.2),
+        leg_min_size(0.05), leg_max_size(0.25), leg_arc_ratio(0.1), leg_ratio_check(true),
+        group_min_size(0.05), group_max_size(1.0)
+    { }
+};
+
+/**
+ * Object detection of all segments of a scan.
+ * Segments are independent, with librobotics_use_openmp they are shared among the
+ * OpenMP threads. Each thread writes into its own lrf_object_arena and line workspace,
+ * and the outputs are merged in segment order, so the result does not depend on the
+ * number of threads or the schedule (same as running the detectors serially).
+ * Human assembly (lb_lrf_object_human_check()) uses legs of several segments, run it on
+ * the merged objects.
+ */
+struct lb_lrf_object_detector {
+    lb_lrf_detect_configuration cfg;
+
+    std::vector<lrf_object_arena> buffer;           //!< output of each thread
+    std::vector<lb_lrf_line_workspace> line_ws;     //!< line workspace of each thread
+    std::vector<int> seg_thread;                    //!< thread of each segment
+    std::vector<int> seg_begin, seg_end;            //!< output of each segment in its buffer
+
+    lb_lrf_object_detector() { }
+    lb_lrf_object_detector(const lb_lrf_detect_configuration& _cfg) : cfg(_cfg) { }
+
+    ///Run the enabled detectors on one segment
+    template<typename O>
+    void detect_segment(const std::vector<vec2f>& points,
+                        const lrf_segment_view& view,
+                        O& objects,
+                        lb_lrf_line_workspace& ws) const
+    {
+        if(cfg.do_line) {
+            lb_lrf_split_and_merge(points, view, objects, cfg.line_min_length, cfg.line_err_threshold,
+                                   ws, cfg.line_merge);
+        }
+        if(cfg.do_arc) {
+            lb_lrf_arc_fiting(points, view, objects, cfg.arc_min_angle, cfg.arc_max_angle,
+                              cfg.arc_max_stdev, cfg.arc_ratio, cfg.arc_is_line_error, cfg.arc_is_line_stdev);
+        }
+        if(cfg.do_leg) {
+            lb_lrf_leg_detect(points, view, objects, cfg.leg_min_size, cfg.leg_max_size,
+                              cfg.leg_arc_ratio, cfg.leg_ratio_check);
+        }
+        if(cfg.do_group) {
+            lb_lrf_group_detect(points, view, objects, cfg.group_min_size, cfg.group_max_size);
+        }
+    }
+
+    /**
+     * Detect objects of all segments.
+     * @param points scan points
+     * @param views segments (lb_lrf_get_segment_view()), output is in this order
+     * @param objects output objects (lrf_object_arena, or std::vector<lrf_object> with points copied)
+     * @return number of objects
+     */
+    template<typename O>
+    int detect(const std::vector<vec2f>& points,
+               const std::vector<lrf_segment_view>& views,
+               O& objects)
+    {
+        int n_thread = 1;
+#if (librobotics_use_openmp == 1)
+        n_thread = omp_get_max_threads();
+#endif
+        if((int)buffer.size() < n_thread) {
+            buffer.resize(n_thread);
+            line_ws.resize(n_thread);
+        }
+        for(int t = 0; t < n_thread; t++) {
+            buffer[t].reset();
+        }
+
+        const int n_view = (int)views.size();
+        seg_thread.resize(n_view);
+        seg_begin.resize(n_view);
+        seg_end.resize(n_view);
+
+#if (librobotics_use_openmp == 1)
+#pragma omp parallel for schedule(dynamic, 4) num_threads(n_thread)
+#endif
+        for(int k = 0; k < n_view; k++) {
+            int t = 0;
+#if (librobotics_use_openmp == 1)
+            t = omp_get_thread_num();
+#endif
+            lrf_object_arena& out = buffer[t];
+            seg_thread[k] = t;
+            seg_begin[k] = (int)out.size();
+            detect_segment(points, views[k], out, line_ws[t]);
+            seg_end[k] = (int)out.size();
+        }
+
+        //merge in segment order
+        size_t first = objects.size();
+        for(int k = 0; k < n_view; k++) {
+            const lrf_object_arena& out = buffer[seg_thread[k]];
+            for(int i = seg_begin[k]; i < seg_end[k]; i++) {
+                objects.push_back(out[i]);
+            }
+        }
+        return (int)(objects.size() - first);
+    }
+
+    ///Detect objects of all segments into lrf_object, with the points of each object copied
+    int detect(const std::vector<vec2f>& points,
+               const std::vector<lrf_segment_view>& views,
+               std::vector<lrf_object>& objects)
+    {
+        size_t first = objects.size();
+        int n_object = detect<std::vector<lrf_object> >(points, views, objects);
+        lb_lrf_object_copy_points(points, objects, first);
+        return n_object;
+    }
+};
 
 }
 
@@ -0,0 +1,224 @@
+/*
+ * lb_lrf_preprocess.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LB_LRF_PREPROCESS_H_
+#define LB_LRF_PREPROCESS_H_
+
+#include "lb_common.h"
+#include "lb_exception.h"
+#include "lb_data_type.h"
+#include "lb_median_filter.h"
+#include "lb_lrf_basic.h"
+
+namespace librobotics {
+
+/**
+ * Configuration of LRF preprocessing, range values are in sensor unit.
+ */
+struct lb_lrf_preprocess_configuration {
+    LB_FLOAT min_range;             //!< range below this is set to 0 (no measurement)
+    LB_FLOAT max_range;             //!< range above this is set to 0 (<= 0 for no limit)
+    int median_half_window;         //!< median filter half window (0 to disable)
+    LB_FLOAT segment_threshold;     //!< range jump that starts a new segment
+    LB_FLOAT scale;                 //!< range to point unit (e.g. 0.001 for mm to m)
+    LB_FLOAT edge_threshold;        //!< mixed pixel/occlusion jump threshold (0 to disable)
+    LB_FLOAT edge_ratio;            //!< range dependent part of the edge threshold
+    unsigned char edge_reject;      //!< condition flags that remove a beam (default LRF_COND_MIXED)
+
+    lb_lrf_preprocess_configuration() :
+        min_range(0),
+        max_range(0),
+        median_half_window(0),
+        segment_threshold(0),
+        scale(1),
+        edge_threshold(0),
+        edge_ratio(0),
+        edge_reject(LRF_COND_MIXED)
+    { }
+};
+
+/**
+ * Scan preprocessing pipeline: range threshold, median filter, point conversion
+ * and range segmentation (same results as lb_lrf_range_threshold_filter(),
+ * lb_lrf_range_median_filter(), lb_lrf_get_scan_point_from_scan_range() and
+ * lb_lrf_range_segment()).
+ * Setup once per sensor, then run() every frame. Threshold is done while copying the
+ * input for the median filter (or inside the last pass without median), conversion and
+ * segmentation share the last pass. All buffers are kept, so frames of the same
+ * size do not allocate.
+ * With cfg.edge_threshold > 0, mixed pixel and occlusion flags (lb_lrf_range_edge_mask())
+ * are computed after the median filter, beams with cfg.edge_reject flags get range 0.
+ * Segments are views of contiguous runs of points (segments[k], id k + 1), they can be
+ * passed directly to the view based detectors of lb_lrf_object_detect.h.
+ * seg and segments follow the point order (reversed from the ranges if the table is flipped).
+ */
+template<typename T>
+struct lb_lrf_preprocess_t {
+    lb_lrf_preprocess_configuration cfg;
+    lb_lrf_scan_table table;                //!< cos/sin of each beam
+
+    std::vector<T> ranges;                  //!< filtered ranges of the last frame
+    std::vector<unsigned char> mask;        //!< condition mask of each range (if edge_threshold > 0)
+    std::vector<vec2f> points;              //!< scan points of the last frame ((0, 0) if no range)
+    std::vector<int> seg;                   //!< segment of each point (1..n_segment, -1 if none)
+    std::vector<lrf_segment_view> segments; //!< segments of the last frame
+    int n_segment;                          //!< number of segments of the last frame
+
+    std::vector<T> buffer;                  //!< median filter input
+    lb_sliding_median_t<T> median_ws;       //!< median filter storage for large window
+
+    lb_lrf_preprocess_t() : n_segment(0) { }
+
+    /**
+     * Setup the pipeline and allocate all buffers.
+     * @param _cfg configuration
+     * @param cos_table sensor cos table
+     * @param sin_table sensor sin table
+     * @param n number of beams per frame
+     * @param start index of the first step
+     * @param cluster steps per beam
+     * @param flip reverse and mirror the scan
+     */
+    void setup(const lb_lrf_preprocess_configuration& _cfg,
+               const std::vector<LB_FLOAT>& cos_table,
+               const std::vector<LB_FLOAT>& sin_table,
+               const size_t n,
+               const int start = 0,
+               const int cluster = 1,
+               const bool flip = false)
+    {
+        cfg = _cfg;
+        table.build(cos_table, sin_table, n, start, cluster, flip);
+        ranges.resize(n);
+        mask.resize(n);
+        points.resize(n);
+        seg.resize(n);
+        buffer.resize(n);
+        segments.reserve(n);
+        n_segment = 0;
+    }
+
+    ///Range threshold (same as lb_lrf_range_threshold_filter() with new value 0)
+    inline T threshold(T r) const {
+        bool out = (r < (T)cfg.min_range) || ((cfg.max_range > 0) && (r > (T)cfg.max_range));
+        return out ? (T)0 : r;
+    }
+
+    /**
+     * Process one frame.
+     * @param input raw range values (table.size() values in sensor order)
+     * @return number of segments
+     */
+    int run(const std::vector<T>& input) {
+        size_t n = table.size();
+        if(input.size() != n) {
+            throw LibRoboticsRuntimeException("%s: scan size %d, expected %d", __FUNCTION__,
+                                              (int)input.size(), (int)n);
+        }
+        segments.clear();
+        n_segment = 0;
+        if(n == 0) return 0;
+
+        //pass 1: threshold and median filter
+        bool median = (cfg.median_half_window > 0);
+        bool edge = (cfg.edge_threshold > 0);
+        if(median) {
+            for(size_t i = 0; i < n; i++) {
+                buffer[i] = threshold(input[i]);
+            }
+            lb_median_filter(&buffer[0], &ranges[0], n, cfg.median_half_window, median_ws);
+        } else if(edge) {
+            for(size_t i = 0; i < n; i++) {
+                ranges[i] = threshold(input[i]);
+            }
+        }
+
+        //mixed pixel and occlusion flags, rejected beams are removed (range 0)
+        if(edge) {
+            for(size_t i = 0; i < n; i++) {
+                mask[i] = (unsigned char)((ranges[i] > 0) ? LRF_COND_NONE : LRF_COND_EMPTY);
+            }
+            lb_lrf_range_edge_mask(&ranges[0], n, &mask[0], cfg.edge_threshold, cfg.edge_ratio);
+            for(size_t i = 0; i < n; i++) {
+                ranges[i] = (mask[i] & cfg.edge_reject) ? (T)0 : ranges[i];
+            }
+        }
+
+        //pass 2: threshold (without median), conversion and segmentation
+        const LB_FLOAT* c = &table.c[0];
+        const LB_FLOAT* s = &table.s[0];
+        bool rev = table.flip;
+        bool in_segment = false;
+        T last_range = 0;
+        for(size_t i = 0; i < n; i++) {
+            //i is the point index, k the range index
+            size_t k = rev ? ((n - 1) - i) : i;
+            T r = (median || edge) ? ranges[k] : (ranges[k] = threshold(input[k]));
+
+            LB_FLOAT d = r * cfg.scale;
+            points[i].x = d * c[i];
+            points[i].y = d * s[i];
+
+            if(r > 0) {
+                if(!in_segment || (fabs((double)r - (double)last_range) > cfg.segment_threshold)) {
+                    if(in_segment) segments.back().end = i;
+                    n_segment++;
+                    segments.push_back(lrf_segment_view(i, i, n_segment));
+                    in_segment = true;
+                }
+                seg[i] = n_segment;
+                last_range = r;
+            } else {
+                if(in_segment) segments.back().end = i;
+                in_segment = false;
+                seg[i] = -1;
+            }
+        }
+        if(in_segment) segments.back().end = n;
+        return n_segment;
+    }
+
+    /**
+     * Copy segments of the last frame to separate vectors (like lb_lrf_create_segment()).
+     * Vectors of result are assigned in place, so their capacity carries over.
+     * @param result points of each segment
+     */
+    void get_segments(std::vector<std::vector<vec2f> >& result) const {
+        result.resize(n_segment);
+        for(int k = 0; k < n_segment; k++) {
+            result[k].assign(points.begin() + segments[k].begin, points.begin() + segments[k].end);
+        }
+    }
+};
+
+typedef lb_lrf_preprocess_t<LB_FLOAT> lb_lrf_preprocess;
+
+}
+
+#endif /* LB_LRF_PREPROCESS_H_ */
@@ -128,5 +128,7 @@
 //load data from configuration file (external/configfile.h)
 #define LOAD_CFG(x, T)  (x = file.read<T>(#x))
 #define LOAD_N_SHOW_CFG(x, T)  LOAD_CFG(x, T); LB_PRINT_VAR(x);
+#define LOAD_CFG_DEFAULT(x, T, v)  (x = file.read<T>(#x, (T)(v)))
+#define LOAD_N_SHOW_CFG_DEFAULT(x, T, v)  LOAD_CFG_DEFAULT(x, T, v); LB_PRINT_VAR(x);
 
 #endif /* LB_MACRO_FUNCTION_H_ */
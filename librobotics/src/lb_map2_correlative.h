@@ -0,0 +1,455 @@
+/*
+ * lb_map2_correlative.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LB_MAP2_CORRELATIVE_H_
+#define LB_MAP2_CORRELATIVE_H_
+
+#include "lb_common.h"
+#include "lb_exception.h"
+#include "lb_data_type.h"
+#include "lb_tools.h"
+#include "lb_statistic_function.h"
+#include "lb_map2_grid.h"
+
+namespace librobotics {
+
+/**
+ * Configuration for correlative scan to map matching
+ */
+struct lb_grid2_correlative_cfg {
+    LB_FLOAT angle_res;             //!< search angle resolution (<= 0 for automatic from scan range)
+    LB_FLOAT free_threshold;        //!< maximum grid value of valid robot position
+    LB_FLOAT min_score;             //!< minimum accepted score \f$(0.0, 1.0)\f$
+    int n_results;                  //!< maximum number of result (top-K)
+    LB_FLOAT result_min_dist;       //!< minimum distance between two results
+    LB_FLOAT result_min_angle;      //!< minimum angle between two results inside result_min_dist
+    unsigned long time_budget;      //!< search time limit in millisecond (0 for no limit)
+
+    lb_grid2_correlative_cfg() :
+        angle_res(0),
+        free_threshold(0),
+        min_score(0.5),
+        n_results(10),
+        result_min_dist(0.5),
+        result_min_angle(M_PI/4),
+        time_budget(500)
+    { }
+};
+
+/**
+ * Max-pooled map pyramid for branch-and-bound search.
+ * Cell (i,j) of level k stores the maximum level 0 value of the
+ * \f$2^k \times 2^k\f$ window that start at grid (i,j). A score on level k
+ * is an upper bound of the score of every grid position inside that window.
+ */
+struct lb_grid2_pyramid {
+    vec2i size;                                 //!< size of the source map
+    std::vector<vec2i> level_size;              //!< size of each level
+    std::vector<std::vector<LB_FLOAT> > level;  //!< level data
+
+    /**
+     * Get value of the window that start at grid (i,j).
+     * @param k pyramid level
+     * @param i grid coordinate \f$[-(2^k-1), size.x)\f$
+     * @param j grid coordinate \f$[-(2^k-1), size.y)\f$
+     * @return window value (0 outside the map)
+     */
+    inline LB_FLOAT get(int k, int i, int j) const {
+        int w = 1 << k;
+        i += w - 1;
+        j += w - 1;
+        const vec2i& s = level_size[k];
+        if((i < 0) || (i >= s.x) || (j < 0) || (j >= s.y))
+            return 0;
+        return level[k][(i * s.y) + j];
+    }
+
+    inline int depth() const {
+        return (int)level.size() - 1;
+    }
+
+    /**
+     * Build pyramid from map.
+     * @param map grid map
+     * @param depth number of level above the map resolution
+     * @param hit_radius dilate radius (grid) of occupied cell on level 0
+     * @param occupied_threshold minimum grid value that count as a hit
+     */
+    inline void build(const lb_grid2_data& map,
+                      int depth,
+                      int hit_radius = 1,
+                      LB_FLOAT occupied_threshold = 0.5)
+    {
+        if(depth < 0) {
+            throw LibRoboticsArgumentException("%s: depth must >= 0", __FUNCTION__);
+        }
+        size = map.size;
+        level.resize(depth + 1);
+        level_size.resize(depth + 1);
+
+        //level 0: dilated occupied grid (separable max filter)
+        size_t n = size.x * size.y;
+        std::vector<LB_FLOAT> hit(n, 0);
+        for(int x = 0; x < size.x; x++) {
+            for(int y = 0; y < size.y; y++) {
+                LB_FLOAT v = map.mapprob[x][y];
+                for(int d = -hit_radius; d <= hit_radius; d++) {
+                    int yy = y + d;
+                    if((yy < 0) || (yy >= size.y) || (map.mapprob[x][yy] < occupied_threshold))
+                        continue;
+                    v = LB_MAX(v, map.mapprob[x][yy]);
+                }
+                hit[(x * size.y) + y] = (v < occupied_threshold) ? 0 : v;
+            }
+        }
+
+        level_size[0] = size;
+        level[0].assign(n, 0);
+        for(int x = 0; x < size.x; x++) {
+            for(int y = 0; y < size.y; y++) {
+                LB_FLOAT v = 0;
+                for(int d = -hit_radius; d <= hit_radius; d++) {
+                    int xx = x + d;
+                    if((xx < 0) || (xx >= size.x))
+                        continue;
+                    v = LB_MAX(v, hit[(xx * size.y) + y]);
+                }
+                level[0][(x * size.y) + y] = v;
+            }
+        }
+
+        //upper level: maximum of four window from the lower level
+        for(int k = 1; k <= depth; k++) {
+            int w = 1 << k;
+            int h = w >> 1;
+            vec2i& s = level_size[k];
+            s.x = size.x + w - 1;
+            s.y = size.y + w - 1;
+            level[k].assign(s.x * s.y, 0);
+            for(int i = -(w - 1); i < size.x; i++) {
+                for(int j = -(w - 1); j < size.y; j++) {
+                    LB_FLOAT v = get(k - 1, i, j);
+                    v = LB_MAX(v, get(k - 1, i + h, j));
+                    v = LB_MAX(v, get(k - 1, i, j + h));
+                    v = LB_MAX(v, get(k - 1, i + h, j + h));
+                    level[k][((i + w - 1) * s.y) + (j + w - 1)] = v;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Result of correlative matching
+ */
+struct lb_grid2_match_result {
+    pose2f p;           //!< robot position
+    LB_FLOAT score;     //!< matching score \f$(0.0, 1.0)\f$
+    lb_grid2_match_result() : score(0) { }
+};
+
+inline bool lb_grid2_match_result_compare(const lb_grid2_match_result& i,
+                                          const lb_grid2_match_result& j)
+{
+    return i.score > j.score;
+}
+
+/**
+ * Branch-and-bound correlative scan to map matcher for global localization.
+ * Search all (x, y, theta) of the map for the best top-K distinct robot positions
+ * that explain the scan, within a time budget.
+ */
+struct lb_grid2_correlative_matcher {
+    struct candidate {
+        int x, y, t;
+        LB_FLOAT score;
+    };
+
+    static bool candidate_compare(const candidate& i, const candidate& j) {
+        return i.score > j.score;
+    }
+
+    lb_grid2_correlative_cfg cfg;
+    std::vector<std::vector<vec2i> > offsets;       //!< discretized scan for each search angle
+    std::vector<vec2f> rotated;                     //!< scan rotated by the current search angle
+    std::vector<std::vector<candidate> > candidates;//!< candidate buffer of each level
+    std::vector<lb_grid2_match_result> result;      //!< top-K result (sorted by score)
+    LB_FLOAT angle_step;                            //!< angle resolution of the last search
+    bool timeout;                                   //!< true if the last search hit the time budget
+    int n_evaluate;                                 //!< number of evaluated candidates
+    unsigned long start_time;
+
+    lb_grid2_correlative_matcher() :
+        angle_step(0), timeout(false), n_evaluate(0), start_time(0)
+    { }
+
+    lb_grid2_correlative_matcher(const lb_grid2_correlative_cfg& _cfg) :
+        cfg(_cfg), angle_step(0), timeout(false), n_evaluate(0), start_time(0)
+    { }
+
+    /**
+     * Search the map for the robot position.
+     * @param map grid map
+     * @param pyramid pyramid of the map
+     * @param z relative LRF measurement point (zero point are ignored)
+     * @return number of result
+     */
+    inline int match(const lb_grid2_data& map,
+                     const lb_grid2_pyramid& pyramid,
+                     const std::vector<vec2f>& z)
+    {
+        result.clear();
+        timeout = false;
+        n_evaluate = 0;
+        start_time = utils_get_current_time();
+
+        if((pyramid.size.x != map.size.x) || (pyramid.size.y != map.size.y)) {
+            throw LibRoboticsRuntimeException("%s: pyramid was not built from this map", __FUNCTION__);
+        }
+
+        //valid measurement and max range
+        LB_FLOAT max_range = 0;
+        size_t n_valid = 0;
+        for(size_t i = 0; i < z.size(); i++) {
+            if(z[i].is_zero()) continue;
+            max_range = LB_MAX(max_range, z[i].size());
+            n_valid++;
+        }
+        if(n_valid == 0) {
+            warn("%s: no valid measurement", __FUNCTION__);
+            return 0;
+        }
+
+        //angle step that move the farthest point less than one grid
+        angle_step = cfg.angle_res;
+        if(angle_step <= 0) {
+            LB_FLOAT d = LB_MAX(max_range, map.resolution);
+            angle_step = acos(1.0 - (LB_SQR(map.resolution) / (2.0 * LB_SQR(d))));
+        }
+        int n_angle = (int)ceil((2 * M_PI) / angle_step);
+
+        //discretize scan for each angle
+        offsets.resize(n_angle);
+        rotated.resize(z.size());
+        for(int t = 0; t < n_angle; t++) {
+            lb_rigid2_apply(rigid2f::rotation(-M_PI + (t * angle_step)), z, rotated);
+            offsets[t].clear();
+            for(size_t i = 0; i < z.size(); i++) {
+                if(z[i].is_zero()) continue;
+                offsets[t].push_back(
+                    vec2i((int)LB_ROUND(rotated[i].x / map.resolution),
+                          (int)LB_ROUND(rotated[i].y / map.resolution)));
+            }
+        }
+
+        //root candidates on the top level
+        int k = pyramid.depth();
+        int w = 1 << k;
+        candidates.resize(k + 1);
+        candidates[k].clear();
+        for(int t = 0; t < n_angle; t++) {
+            for(int x = 0; x < map.size.x; x += w) {
+                for(int y = 0; y < map.size.y; y += w) {
+                    candidate c;
+                    c.x = x; c.y = y; c.t = t;
+                    c.score = score(pyramid, k, c);
+                    candidates[k].push_back(c);
+                }
+            }
+        }
+        std::sort(candidates[k].begin(), candidates[k].end(), candidate_compare);
+
+        branch(map, pyramid, k);
+
+        if(timeout) {
+            debug("%s: time budget exceeded after %d candidates", __FUNCTION__, n_evaluate);
+        }
+        return (int)result.size();
+    }
+
+    inline LB_FLOAT score(const lb_grid2_pyramid& pyramid, int k, const candidate& c) {
+        const std::vector<vec2i>& o = offsets[c.t];
+        LB_FLOAT sum = 0;
+        for(size_t i = 0; i < o.size(); i++) {
+            sum += pyramid.get(k, c.x + o[i].x, c.y + o[i].y);
+        }
+        n_evaluate++;
+        return sum / o.size();
+    }
+
+    inline LB_FLOAT min_score() const {
+        if((int)result.size() < cfg.n_results)
+            return cfg.min_score;
+        return LB_MAX(cfg.min_score, result.back().score);
+    }
+
+    inline void branch(const lb_grid2_data& map,
+                       const lb_grid2_pyramid& pyramid,
+                       int k)
+    {
+        std::vector<candidate>& c = candidates[k];
+        for(size_t i = 0; i < c.size(); i++) {
+            if(c[i].score <= min_score())
+                return;     //sorted, all remaining candidates are worse
+
+            if(k == 0) {
+                add_result(map, c[i]);
+                continue;
+            }
+
+            if((cfg.time_budget > 0) &&
+               ((utils_get_current_time() - start_time) > cfg.time_budget))
+            {
+                timeout = true;
+            }
+            if(timeout) return;
+
+            //split to four children on the lower level
+            int h = 1 << (k - 1);
+            std::vector<candidate>& child = candidates[k - 1];
+            child.clear();
+            for(int dx = 0; dx <= h; dx += h) {
+                for(int dy = 0; dy <= h; dy += h) {
+                    candidate n = c[i];
+                    n.x += dx;
+                    n.y += dy;
+                    if((n.x >= map.size.x) || (n.y >= map.size.y))
+                        continue;
+                    n.score = score(pyramid, k - 1, n);
+                    child.push_back(n);
+                }
+            }
+            std::sort(child.begin(), child.end(), candidate_compare);
+            branch(map, pyramid, k - 1);
+        }
+    }
+
+    inline bool near_result(const lb_grid2_match_result& a, const lb_grid2_match_result& b) const {
+        return ((a.p.get_vec2() - b.p.get_vec2()).size() < cfg.result_min_dist) &&
+               (fabs(lb_minimum_angle_distance(a.p.a, b.p.a)) < cfg.result_min_angle);
+    }
+
+    inline void add_result(const lb_grid2_data& map, const candidate& c) {
+        //robot must be on the free space
+        if(map.mapprob[c.x][c.y] > cfg.free_threshold)
+            return;
+
+        lb_grid2_match_result r;
+        vec2f pts;
+        map.get_grid_position(c.x, c.y, pts);
+        r.p = pose2f(pts.x, pts.y, lb_normalize_angle(-M_PI + (c.t * angle_step)));
+        r.score = c.score;
+
+        //keep only the best result around the same position
+        for(size_t i = 0; i < result.size(); i++) {
+            if(near_result(result[i], r) && (result[i].score >= r.score))
+                return;
+        }
+        size_t k = 0;
+        for(size_t i = 0; i < result.size(); i++) {
+            if(near_result(result[i], r)) continue;
+            if(k != i) result[k] = result[i];
+            k++;
+        }
+        result.resize(k);
+
+        result.push_back(r);
+        std::sort(result.begin(), result.end(), lb_grid2_match_result_compare);
+        if((int)result.size() > cfg.n_results)
+            result.pop_back();
+    }
+};
+
+/**
+ * Initialize 2D position of all particle around the matching results.
+ * Number of particle for each result is proportional to its score (largest remainder),
+ * each result gets at least one particle if there are enough particles.
+ * @param p std::vector<> of particle
+ * @param candidates matching results
+ * @param radius position spread around each result (uniform in circle)
+ * @param angle_var angle spread around each result (normal distribution)
+ * @return false if there is no result to seed with
+ */
+template<typename P>
+bool lb_init_particle2_from_candidates(std::vector<P>& p,
+                                       const std::vector<lb_grid2_match_result>& candidates,
+                                       LB_FLOAT radius,
+                                       LB_FLOAT angle_var)
+{
+    size_t n = p.size();
+    size_t k = candidates.size();
+    if((k == 0) || (n == 0))
+        return false;
+
+    LB_FLOAT sum = 0;
+    for(size_t i = 0; i < k; i++) {
+        sum += candidates[i].score;
+    }
+
+    //one particle for each result first, the rest by score
+    size_t base = (n >= k) ? 1 : 0;
+    size_t rest = n - base * k;
+    std::vector<size_t> cnt(k, base);
+    std::vector<std::pair<LB_FLOAT, size_t> > remainder(k);
+    size_t given = 0;
+    for(size_t i = 0; i < k; i++) {
+        LB_FLOAT share = (sum > 0) ? (rest * (candidates[i].score / sum)) : ((LB_FLOAT)rest / k);
+        size_t whole = (size_t)floor(share);
+        cnt[i] += whole;
+        given += whole;
+        remainder[i] = std::make_pair(-(share - whole), i);     //largest fraction first
+    }
+    std::sort(remainder.begin(), remainder.end());
+    for(size_t j = 0; (j < k) && (given < rest); j++, given++) {
+        cnt[remainder[j].second]++;
+    }
+
+    size_t idx = 0;
+    LB_FLOAT r, a;
+    for(size_t i = 0; i < k; i++) {
+        const pose2f& start = candidates[i].p;
+        for(size_t j = 0; (j < cnt[i]) && (idx < n); j++, idx++) {
+            lb_sample_circle_uniform_dist(a, r);
+            p[idx].p.x = start.x + (r * radius * cos(a));
+            p[idx].p.y = start.y + (r * radius * sin(a));
+            p[idx].p.a = lb_normalize_angle(start.a + lb_sample_normal_dist(angle_var));
+        }
+    }
+
+    for(size_t i = 0; i < n; i++) {
+        p[i].w = 1.0/n;
+    }
+    return true;
+}
+
+}
+
+
+#endif /* LB_MAP2_CORRELATIVE_H_ */
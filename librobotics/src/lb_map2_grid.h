@@ -39,21 +39,25 @@ namespace librobotics {
 
     /**
      * Data structure for 2D grid map.
+     * T is the numeric type of the map values and caches (float or double).
      */
-    struct lb_grid2_data {
+    template<typename T>
+    struct lb_grid2_data_t {
+        typedef T value_type;
+
         vec2i       size;           //!< Size of the map
         vec2i       center;         //!< Center of the map
-        pose2f      offset;         //!< Map offset in real world unit (m, mm, cm...)
-        LB_FLOAT    resolution;     //!< Map resolution real world unit/map size unit
-        LB_FLOAT    angle_res;
+        pose2<T>    offset;         //!< Map offset in real world unit (m, mm, cm...)
+        T           resolution;     //!< Map resolution real world unit/map size unit
+        T           angle_res;
         int         angle_step;
-        std::vector<std::vector<LB_FLOAT> > mapprob;           //!< Value of each grid cell
-        std::vector<std::vector<LB_FLOAT> > dyn_mapprob;       //!< dynamic value of each grid cell
+        std::vector<std::vector<T> > mapprob;           //!< Value of each grid cell
+        std::vector<std::vector<T> > dyn_mapprob;       //!< dynamic value of each grid cell
 
         std::vector<std::vector<int> > gradient_map;
         std::vector<std::vector<int> > gradient_intr;
 
-        std::vector<std::vector<std::vector<LB_FLOAT> > > ray_casting_cache;
+        std::vector<std::vector<std::vector<T> > > ray_casting_cache;
 
         void show_information() {
             LB_PRINT_VAR(size);
@@ -79,7 +83,8 @@ namespace librobotics {
          * @param pts
          * @return true if (x,y) is inside the map
          */
-        inline bool get_grid_position(int x, int y, vec2f& pts) const {
+        template<typename T1>
+        inline bool get_grid_position(int x, int y, vec2<T1>& pts) const {
             if(is_inside(x, y)) {
                 pts.x = ((x - center.x) * resolution) + offset.x;
                 pts.y = ((y - center.y) * resolution) + offset.y;
@@ -96,7 +101,7 @@ namespace librobotics {
          * @param v result in grid coordinate
          * @return true if (x,y) is inside the map
          */
-        inline bool get_grid_coordinate(LB_FLOAT x, LB_FLOAT y, vec2i& v) const {
+        inline bool get_grid_coordinate(T x, T y, vec2i& v) const {
             v.x = center.x + (int)LB_ROUND((x-offset.x)/resolution);
             v.y = center.y + (int)LB_ROUND((y-offset.y)/resolution);
             if(is_inside(v.x, v.y))
@@ -106,7 +111,8 @@ namespace librobotics {
             }
         }
 
-        inline bool get_random_pts(vec2f& pts, LB_FLOAT max_mapprob = 0.0, int retry = 100) const {
+        template<typename T1>
+        inline bool get_random_pts(vec2<T1>& pts, T max_mapprob = 0.0, int retry = 100) const {
             int x, y;
             bool pass = false;
             do {
@@ -134,7 +140,7 @@ namespace librobotics {
          *          1 if hit \n
          *          2 if not hit
          */
-        inline int get_ray_casting_hit_point(int x, int y, LB_FLOAT dir, vec2i& hit_grid) {
+        inline int get_ray_casting_hit_point(int x, int y, LB_FLOAT dir, vec2i& hit_grid) const {
             //outside the map
             if(!is_inside(x, y))
                 return -1;
@@ -212,7 +218,7 @@ namespace librobotics {
          * Pre-compute ray casting result of all unoccupied gird.
          * @param angle_res ray casting angle resolution in radian
          */
-        inline void compute_ray_casting_cache(LB_FLOAT _angle_res, LB_FLOAT threshold = 0) {
+        inline void compute_ray_casting_cache(T _angle_res, T threshold = 0) {
             if(_angle_res <= 0) {
                 throw LibRoboticsRuntimeException("angle resolution must > 0");
             }
@@ -238,7 +244,7 @@ namespace librobotics {
                     for(int i = 0; i < angle_step; i++) {
                         result = get_ray_casting_hit_point(x, y, i * angle_res, hit);
                         if(result == 1) {
-                            ray_casting_cache[x][y][i] = LB_SIZE((LB_FLOAT)(x-hit.x), (LB_FLOAT)(y-hit.y)) * resolution;
+                            ray_casting_cache[x][y][i] = (T)(LB_SIZE((LB_FLOAT)(x-hit.x), (LB_FLOAT)(y-hit.y)) * resolution);
                         } else {
                             ray_casting_cache[x][y][i] = -1;    //no measurement on that direction
                         }
@@ -249,10 +255,10 @@ namespace librobotics {
             LB_PRINT_STREAM << "done! with " << cnt << " ray casting operations\n";
         }
 
-        inline bool get_gradient_path(const vec2f& start,
-                                     const vec2f& goal,
+        inline bool get_gradient_path(const vec2<T>& start,
+                                     const vec2<T>& goal,
                                      std::vector<vec2i>& path,
-                                     LB_FLOAT clearance)
+                                     T clearance)
         {
             vec2i grid_start;
             vec2i grid_goal;
@@ -459,7 +465,7 @@ namespace librobotics {
          */
         inline cimg8u get_image(bool flip_x = false,
                                 bool flip_y = true,
-                                bool invert = true)
+                                bool invert = true) const
         {
             using namespace cimg_library;
             cimg8u img(size.x, size.y, 1, 3, 0);
@@ -484,6 +490,16 @@ namespace librobotics {
         }
 #endif //(librobotics_use_cimg == 1)
     };
+
+    typedef lb_grid2_data_t<LB_FLOAT> lb_grid2_data;
+    typedef lb_grid2_data_t<float> lb_grid2_data_f32;
+    typedef lb_grid2_data_t<double> lb_grid2_data_f64;
+
+    /**
+     * Read-only grid map (including its caches) shared by several users,
+     * e.g. many MCL instances on the same map.
+     */
+    typedef boost::shared_ptr<const lb_grid2_data> lb_grid2_shared_data;
 }
 
 
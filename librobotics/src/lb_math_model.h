@@ -33,6 +33,7 @@
 #include "lb_common.h"
 #include "lb_data_type.h"
 #include "lb_statistic_function.h"
+#include "lb_fast_math.h"
 
 namespace librobotics {
 
@@ -91,8 +92,8 @@ inline pose2f lb_velocity_motion_model_sample(const vec2f& ut,
         y = p.y + v_w*cos(p.a) - v_w*cos(p.a + w*dt);
         a = lb_normalize_angle(p.a + w*dt + r*dt);
     } else {
-        x = p.x + v*cos(p.a);
-        y = p.y + v*sin(p.a);
+        x = p.x + v*dt*cos(p.a);
+        y = p.y + v*dt*sin(p.a);
         a = lb_normalize_angle(p.a + r*dt);
     }
     return pose2f(x, y, a);
@@ -192,6 +193,219 @@ inline pose2f lb_odometry_motion_model_sample(const pose2f& u_pt,
     return pose2f(x, y, a);
 }
 
+/**
+ * Workspace for batch motion model sampling, keep it between steps
+ * to avoid allocation. T is the numeric type of the particle poses.
+ */
+template<typename T>
+struct lb_motion_model_workspace_t {
+    std::vector<T> noise[3];            //!< sampled noise
+    std::vector<T> angle;               //!< heading of each sample
+    std::vector<T> c, s;                //!< cos/sin of angle
+
+    void resize(size_t n) {
+        for(int i = 0; i < 3; i++) {
+            if(noise[i].size() < n) noise[i].resize(n);
+        }
+        if(angle.size() < n) angle.resize(n);
+        if(c.size() < n) c.resize(n);
+        if(s.size() < n) s.resize(n);
+    }
+};
+
+typedef lb_motion_model_workspace_t<LB_FLOAT> lb_motion_model_workspace;
+
+///Pose of a particle (any type with member p and typedef pose_type)
+template<typename P>
+inline typename P::pose_type& lb_pose_of(P& p) {
+    return p.p;
+}
+
+///Pose of a pose
+template<typename T>
+inline pose2<T>& lb_pose_of(pose2<T>& p) {
+    return p;
+}
+
+/**
+ * Batch sample based odometry motion model for a whole particle set.
+ * The odometry decomposition and noise deviations are computed once, all noise is
+ * drawn in bulk and the poses are updated in SoA loops.
+ * @param u_pt current odometry position
+ * @param u_p last odometry position
+ * @param p particles (or poses) to move, updated in place
+ * @param var robot specific motion error parameters \f$(\sigma_0 ... \sigma_3) \f$
+ * @param ws workspace
+ * @param rng batch random engine
+ * @tparam M math policy (lb_math_exact, lb_math_fast, lb_math_approx)
+ */
+template<typename M, typename P, typename T>
+inline void lb_odometry_motion_model_sample(const pose2f& u_pt,
+                                            const pose2f& u_p,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT var[4],
+                                            lb_motion_model_workspace_t<T>& ws,
+                                            lb_rng_x4& rng)
+{
+    size_t n = p.size();
+    if(n == 0) return;
+
+    //per step quantities
+    LB_FLOAT rot1 = lb_minimum_angle_distance(u_p.a, atan2(u_pt.y - u_p.y, u_pt.x - u_p.x));
+    LB_FLOAT tran = (u_pt.get_vec2() - u_p.get_vec2()).size();
+    LB_FLOAT rot2 = lb_minimum_angle_distance(rot1, lb_minimum_angle_distance(u_p.a, u_pt.a));
+
+    LB_FLOAT rot1_sqr = LB_SQR(rot1);
+    LB_FLOAT tran_sqr = LB_SQR(tran);
+    LB_FLOAT rot2_sqr = LB_SQR(rot2);
+
+    ws.resize(n);
+    lb_sample_normal_dist_fill(rng, &ws.noise[0][0], n, (T)(var[0]*rot1_sqr + var[1]*tran_sqr));
+    lb_sample_normal_dist_fill(rng, &ws.noise[1][0], n, (T)(var[2]*tran_sqr + var[3]*rot1_sqr + var[3]*rot2_sqr));
+    lb_sample_normal_dist_fill(rng, &ws.noise[2][0], n, (T)(var[0]*rot2_sqr + var[1]*tran_sqr));
+
+    //per step quantities in particle precision
+    const T t_rot1 = (T)rot1;
+    const T t_tran = (T)tran;
+    const T t_rot2 = (T)rot2;
+
+    T* nrot1 = &ws.noise[0][0];
+    T* ntran = &ws.noise[1][0];
+    T* nrot2 = &ws.noise[2][0];
+    T* a = &ws.angle[0];
+    T* c = &ws.c[0];
+    T* s = &ws.s[0];
+
+    for(size_t i = 0; i < n; i++) {
+        a[i] = lb_pose_of(p[i]).a + t_rot1 + nrot1[i];
+    }
+    lb_sincos_array<M>(a, s, c, n);
+    for(size_t i = 0; i < n; i++) {
+        pose2<T>& pi = lb_pose_of(p[i]);
+        T t = t_tran + ntran[i];
+        pi.x += t * c[i];
+        pi.y += t * s[i];
+        pi.a = M::wrap(a[i] + t_rot2 + nrot2[i]);
+    }
+}
+
+/**
+ * Batch sample based odometry motion model with lb_math_default.
+ */
+template<typename P, typename T>
+inline void lb_odometry_motion_model_sample(const pose2f& u_pt,
+                                            const pose2f& u_p,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT var[4],
+                                            lb_motion_model_workspace_t<T>& ws,
+                                            lb_rng_x4& rng)
+{
+    lb_odometry_motion_model_sample<lb_math_default>(u_pt, u_p, p, var, ws, rng);
+}
+
+/**
+ * Batch sample based odometry motion model with the batch random engine of the calling thread.
+ */
+template<typename P, typename T>
+inline void lb_odometry_motion_model_sample(const pose2f& u_pt,
+                                            const pose2f& u_p,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT var[4],
+                                            lb_motion_model_workspace_t<T>& ws)
+{
+    lb_odometry_motion_model_sample<lb_math_default>(u_pt, u_p, p, var, ws, lb_rng_x4_default());
+}
+
+/**
+ * Batch sample based velocity motion model for a whole particle set.
+ * The arc is applied as a chord of length \f$2\frac{v}{w}\sin(\frac{w\Delta t}{2})\f$ along
+ * heading \f$\theta + \frac{w\Delta t}{2}\f$, which is exact and has no branch for \f$w = 0\f$.
+ * @param ut control \f$(v, w)^T\f$
+ * @param p particles (or poses) to move, updated in place
+ * @param dt update time
+ * @param var robot specific motion error parameters \f$(\sigma_1 ... \sigma_6) \f$
+ * @param ws workspace
+ * @param rng batch random engine
+ * @tparam M math policy (lb_math_exact, lb_math_fast, lb_math_approx)
+ */
+template<typename M, typename P, typename T>
+inline void lb_velocity_motion_model_sample(const vec2f& ut,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT dt,
+                                            const LB_FLOAT var[6],
+                                            lb_motion_model_workspace_t<T>& ws,
+                                            lb_rng_x4& rng)
+{
+    size_t n = p.size();
+    if(n == 0) return;
+
+    LB_FLOAT v2 = LB_SQR(ut.x);
+    LB_FLOAT w2 = LB_SQR(ut.y);
+
+    ws.resize(n);
+    lb_sample_normal_dist_fill(rng, &ws.noise[0][0], n, (T)(var[0]*v2 + var[1]*w2));
+    lb_sample_normal_dist_fill(rng, &ws.noise[1][0], n, (T)(var[2]*v2 + var[3]*w2));
+    lb_sample_normal_dist_fill(rng, &ws.noise[2][0], n, (T)(var[4]*v2 + var[5]*w2));
+
+    //per step quantities in particle precision
+    const T v = (T)ut.x;
+    const T w = (T)ut.y;
+    const T t_dt = (T)dt;
+    const T half = (T)0.5;
+    const T eps = (T)1e-6;
+
+    T* l = &ws.noise[0][0];             //noise of v, then chord length
+    T* h = &ws.noise[1][0];             //noise of w, then half turn
+    T* r = &ws.noise[2][0];
+    T* a = &ws.angle[0];
+    T* c = &ws.c[0];
+    T* s = &ws.s[0];
+
+    for(size_t i = 0; i < n; i++) {
+        T hi = half * (w + h[i]) * t_dt;
+        T t = (v + l[i]) * t_dt;
+        T sh, ch;
+        M::sincos(hi, sh, ch);
+        l[i] = (fabs(hi) > eps) ? (t * sh / hi) : t;
+        h[i] = hi;
+        a[i] = lb_pose_of(p[i]).a + hi;
+    }
+    lb_sincos_array<M>(a, s, c, n);
+    for(size_t i = 0; i < n; i++) {
+        pose2<T>& pi = lb_pose_of(p[i]);
+        pi.x += l[i] * c[i];
+        pi.y += l[i] * s[i];
+        pi.a = M::wrap(a[i] + h[i] + r[i]*t_dt);
+    }
+}
+
+/**
+ * Batch sample based velocity motion model with lb_math_default.
+ */
+template<typename P, typename T>
+inline void lb_velocity_motion_model_sample(const vec2f& ut,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT dt,
+                                            const LB_FLOAT var[6],
+                                            lb_motion_model_workspace_t<T>& ws,
+                                            lb_rng_x4& rng)
+{
+    lb_velocity_motion_model_sample<lb_math_default>(ut, p, dt, var, ws, rng);
+}
+
+/**
+ * Batch sample based velocity motion model with the batch random engine of the calling thread.
+ */
+template<typename P, typename T>
+inline void lb_velocity_motion_model_sample(const vec2f& ut,
+                                            std::vector<P>& p,
+                                            const LB_FLOAT dt,
+                                            const LB_FLOAT var[6],
+                                            lb_motion_model_workspace_t<T>& ws)
+{
+    lb_velocity_motion_model_sample<lb_math_default>(ut, p, dt, var, ws, lb_rng_x4_default());
+}
+
 /**
  * Odometry motion model
  * @param pt
@@ -33,30 +33,39 @@
 #include "lb_common.h"
 #include "lb_exception.h"
 #include "lb_data_type.h"
+#include "lb_tools.h"
+#include "lb_math_model.h"
 #include "lb_map2_grid.h"
+#include "lb_lrf_basic.h"
 
 namespace librobotics {
 
 /**
  *  Data structure for particle in 2D MCL
  */
-struct lb_mcl2_particle {
-    pose2f p;                   //!< robot position
-    LB_FLOAT w;                 //!< weight
-    lb_mcl2_particle() : w(0) { }
+template<typename T>
+struct lb_mcl2_particle_t {
+    typedef pose2<T> pose_type;
+
+    pose2<T> p;                 //!< robot position
+    T w;                        //!< weight
+    lb_mcl2_particle_t() : w(0) { }
 
     ///Support for output stream operator
-    friend std::ostream& operator << (std::ostream& os, const lb_mcl2_particle& p) {
+    friend std::ostream& operator << (std::ostream& os, const lb_mcl2_particle_t& p) {
         return os << p.p << " " << p.w;
     }
 
     ///Support for input stream operator
-    friend std::istream& operator >> (std::istream& is, lb_mcl2_particle& p) {
+    friend std::istream& operator >> (std::istream& is, lb_mcl2_particle_t& p) {
         is >> p.p >> p.w;
         return is;
     }
 };
 
+typedef lb_mcl2_particle_t<LB_FLOAT> lb_mcl2_particle;
+typedef lb_mcl2_particle_t<float> lb_mcl2_particle_f32;
+
 
 /**
  * Configuration for MCL on grid2 map
@@ -76,7 +85,19 @@ struct lb_mcl_grid2_configuration {
     LB_FLOAT z_hit_var;         //!< measurement hit target variance (normal distribution)
     LB_FLOAT z_short_rate;      //!< measurement too short rate (exponential distribution)
     LB_FLOAT z_weight[4];       //!< normalized weight for all possible measurement outcome
+    int z_max_beams;            //!< maximum beams per update (0 for down sample mode)
+    LB_FLOAT z_time_budget;     //!< measurement update time budget in microsecond (0 for no limit)
+    LB_FLOAT update_min_d;      //!< translation since last update that trigger measurement update (0 off)
+    LB_FLOAT update_min_a;      //!< rotation since last update that trigger measurement update (0 off)
 
+    lb_mcl_grid2_configuration() :
+        z_max_beams(0),
+        z_time_budget(0),
+        update_min_d(0),
+        update_min_a(0)
+    {
+        motion_var[4] = motion_var[5] = 0;
+    }
 
     /**
      * Load the configuration from text file
@@ -99,8 +120,8 @@ struct lb_mcl_grid2_configuration {
             LOAD_N_SHOW_CFG(motion_var[1], LB_FLOAT);
             LOAD_N_SHOW_CFG(motion_var[2], LB_FLOAT);
             LOAD_N_SHOW_CFG(motion_var[3], LB_FLOAT);
-//            LOAD_N_SHOW_CFG(motion_var[4], LB_FLOAT);
-//            LOAD_N_SHOW_CFG(motion_var[5], LB_FLOAT);
+            LOAD_N_SHOW_CFG_DEFAULT(motion_var[4], LB_FLOAT, 0);
+            LOAD_N_SHOW_CFG_DEFAULT(motion_var[5], LB_FLOAT, 0);
 
             LOAD_N_SHOW_CFG(map_var, LB_FLOAT);
             LOAD_N_SHOW_CFG(z_max_range, LB_FLOAT);
@@ -110,6 +131,10 @@ struct lb_mcl_grid2_configuration {
             LOAD_N_SHOW_CFG(z_weight[1], LB_FLOAT);
             LOAD_N_SHOW_CFG(z_weight[2], LB_FLOAT);
             LOAD_N_SHOW_CFG(z_weight[3], LB_FLOAT);
+            LOAD_N_SHOW_CFG_DEFAULT(z_max_beams, int, 0);
+            LOAD_N_SHOW_CFG_DEFAULT(z_time_budget, LB_FLOAT, 0);
+            LOAD_N_SHOW_CFG_DEFAULT(update_min_d, LB_FLOAT, 0);
+            LOAD_N_SHOW_CFG_DEFAULT(update_min_a, LB_FLOAT, 0);
             LB_PRINT_VAL("===============================================");
         } catch (std::string& e) {
             LB_PRINT_STREAM << e;
@@ -119,73 +144,228 @@ struct lb_mcl_grid2_configuration {
 
 
 /**
- * Data structure for MCL on grid2 map
+ * Data structure for MCL on grid2 map.
+ * T is the numeric type of particles, map and per-beam data (float or double),
+ * odometry and control input stay in LB_FLOAT.
  */
-struct lb_mcl_grid2_data {
-    std::vector<lb_mcl2_particle> p;         //!< current particle set
-    std::vector<lb_mcl2_particle> p_tmp;     //!< temporary particle set
-    lb_grid2_data map;                       //!< gird map
-    pose2f last_odo_pose;                    //!< last odometry position
+template<typename T>
+struct lb_mcl_grid2_data_t {
+    typedef lb_grid2_data_t<T> map_type;
+    typedef boost::shared_ptr<const map_type> shared_map_type;
+
+    std::vector<lb_mcl2_particle_t<T> > p;       //!< current particle set
+    std::vector<lb_mcl2_particle_t<T> > p_tmp;   //!< temporary particle set
+    shared_map_type map;                         //!< grid map (shared, read-only)
+    pose2f last_odo_pose;                        //!< odometry position of the last update
+    LB_FLOAT motion_d;                           //!< translation predicted since the last update (velocity mode)
+    LB_FLOAT motion_a;                           //!< rotation predicted since the last update (velocity mode)
+    lb_motion_model_workspace_t<T> motion_ws;    //!< workspace for batch prediction
+
+    std::vector<int> beam_index;             //!< selected beams of current scan
+    lb_lrf_beam_bits beam_valid;             //!< usable beams of current scan
+    std::vector<T> beam_angle;               //!< relative angle of selected beams
+    std::vector<T> beam_range;               //!< range of selected beams
+    LB_FLOAT beam_cost;                      //!< measured cost per particle per beam (microsecond)
+
+    bool force_update;                       //!< run next update regardless of motion
+    bool updated;                            //!< true if the last call ran the measurement update
+    unsigned long update_time;               //!< time used by the last update (microsecond)
+    size_t update_evaluations;               //!< measurement evaluations of the last update (particles x beams)
+    int n_update;                            //!< number of updates
+    int n_skip;                              //!< number of skipped calls
+
+    lb_mcl_grid2_data_t() :
+        motion_d(0),
+        motion_a(0),
+        beam_cost(0),
+        force_update(true),
+        updated(false),
+        update_time(0),
+        update_evaluations(0),
+        n_update(0),
+        n_skip(0)
+    { }
 
     /**
-     * Initialize data with information form configuration data
+     * Initialize data with information form configuration data.
+     * The map is loaded and its ray casting cache is computed.
      * @param cfg
      */
     void initialize(const lb_mcl_grid2_configuration& cfg) {
+        initialize(cfg, load_map(cfg));
+    }
+
+    /**
+     * Initialize data with an already loaded map.
+     * Only the particles are allocated, the map is shared.
+     * @param cfg
+     * @param shared_map map from load_map() or other MCL data
+     */
+    void initialize(const lb_mcl_grid2_configuration& cfg,
+                    const shared_map_type& shared_map)
+    {
+        if(!shared_map) {
+            throw LibRoboticsArgumentException("%s: map is empty", __FUNCTION__);
+        }
         p.resize(cfg.n_particles);
         p_tmp.resize(cfg.n_particles);
-        map.load_config(cfg.map_config_file);
-        map.load_map_image(cfg.map_image_file);
+        map = shared_map;
+        motion_d = motion_a = 0;
+        force_update = true;
+    }
 
-        //compute ray_cast cache
-        map.compute_ray_casting_cache(cfg.map_angle_res);
+    /**
+     * Load the map and compute ray casting cache for sharing between MCL data
+     * @param cfg
+     * @return read-only map
+     */
+    static shared_map_type load_map(const lb_mcl_grid2_configuration& cfg) {
+        boost::shared_ptr<map_type> m(new map_type);
+        m->load_config(cfg.map_config_file);
+        m->load_map_image(cfg.map_image_file);
 
+        //compute ray_cast cache
+        m->compute_ray_casting_cache(cfg.map_angle_res);
+        return m;
     }
 };
 
+typedef lb_mcl_grid2_data_t<LB_FLOAT> lb_mcl_grid2_data;
+typedef lb_mcl_grid2_data_t<float> lb_mcl_grid2_data_f32;
+
 /**
- * Monte Carlo Localization (MCL) in 2D grid map
+ * Number of beams that fit in the measurement update budget.
+ * @param cfg configuration data
+ * @param data MCL2 data structure (beam_cost from the last update)
+ * @return maximum number of beams for the next update
+ */
+template<typename T>
+inline size_t lb_mcl_grid2_beam_budget(const lb_mcl_grid2_configuration& cfg,
+                                       const lb_mcl_grid2_data_t<T>& data)
+{
+    size_t n = (cfg.z_max_beams > 0) ? cfg.z_max_beams : (std::numeric_limits<int>::max)();
+    if((cfg.z_time_budget > 0) && (data.beam_cost > 0) && (cfg.n_particles > 0)) {
+        size_t n_time = (size_t)(cfg.z_time_budget / (data.beam_cost * cfg.n_particles));
+        n = LB_MIN(n, LB_MAX(n_time, (size_t)1));
+    }
+    return n;
+}
+
+/**
+ * Check a motion against the update thresholds. A threshold of 0 turns its axis off,
+ * with both off every motion triggers the update.
+ * @param cfg configuration data
+ * @param d translation since the last update
+ * @param a rotation since the last update
+ * @return true if the motion triggers the measurement update
+ */
+inline bool lb_mcl_grid2_motion_reached(const lb_mcl_grid2_configuration& cfg,
+                                        const LB_FLOAT d,
+                                        const LB_FLOAT a)
+{
+    if((cfg.update_min_d <= 0) && (cfg.update_min_a <= 0))
+        return true;
+    return ((cfg.update_min_d > 0) && (d >= cfg.update_min_d)) ||
+           ((cfg.update_min_a > 0) && (a >= cfg.update_min_a));
+}
+
+/**
+ * Check the motion since the last update against update thresholds.
  * @param cfg configuration data
- * @param z vector relative LRF measurement point
  * @param odo_pose odometry measurement at current position
  * @param data MCL2 data structure
+ * @return true if the measurement update should run
+ */
+template<typename T>
+inline bool lb_mcl_grid2_need_update(const lb_mcl_grid2_configuration& cfg,
+                                     const pose2f& odo_pose,
+                                     const lb_mcl_grid2_data_t<T>& data)
+{
+    if(data.force_update)
+        return true;
+    LB_FLOAT d = (odo_pose.get_vec2() - data.last_odo_pose.get_vec2()).size();
+    LB_FLOAT a = fabs(lb_minimum_angle_distance(data.last_odo_pose.a, odo_pose.a));
+    return lb_mcl_grid2_motion_reached(cfg, d, a);
+}
+
+/**
+ * Select beams of the scan for the measurement update into data.beam_index.
+ * If cfg.z_max_beams or cfg.z_time_budget is set, beams are chosen by lb_lrf_select_beam()
+ * within the budget, otherwise every z_down_sample-th beam is used.
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param data MCL2 data structure
  * @param z_down_sample measurement down sample
- * @return
  */
-inline int lb_mcl_grid2_update_with_odomety(const lb_mcl_grid2_configuration& cfg,
-                                            const std::vector<vec2f>& z,
-                                            const pose2f& odo_pose,
-                                            lb_mcl_grid2_data& data,
-                                            int z_down_sample = 1)
+template<typename T, typename S>
+inline void lb_mcl_grid2_select_beam(const lb_mcl_grid2_configuration& cfg,
+                                     const std::vector<vec2<S> >& z,
+                                     lb_mcl_grid2_data_t<T>& data,
+                                     int z_down_sample = 1)
+{
+    if((cfg.z_max_beams > 0) || (cfg.z_time_budget > 0)) {
+        lb_lrf_get_valid_beam(z, data.beam_valid, cfg.z_max_range);
+        lb_lrf_select_beam(z, data.beam_valid, data.beam_index, lb_mcl_grid2_beam_budget(cfg, data));
+    } else {
+        if(z_down_sample < 1) z_down_sample = 1;
+        data.beam_index.clear();
+        for(size_t i = 0; i < z.size(); i += z_down_sample) {
+            data.beam_index.push_back(i);
+        }
+    }
+}
+
+/**
+ * Measurement update of the current (already predicted) particle set.
+ * Weights of all particles are recomputed from the selected beams and the
+ * update statistics are recorded. Motion gating is done by the caller.
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param beam_index index of beams in z to use for measurement update
+ * @param data MCL2 data structure
+ */
+template<typename T, typename S>
+inline void lb_mcl_grid2_measurement_update(const lb_mcl_grid2_configuration& cfg,
+                                            const std::vector<vec2<S> >& z,
+                                            const std::vector<int>& beam_index,
+                                            lb_mcl_grid2_data_t<T>& data)
 {
+    //beam angle and range are computed once per scan
+    size_t n_beams = beam_index.size();
+    data.beam_angle.resize(n_beams);
+    data.beam_range.resize(n_beams);
+    for(size_t i = 0; i < n_beams; i++) {
+        data.beam_angle[i] = (T)z[beam_index[i]].theta();
+        data.beam_range[i] = (T)z[beam_index[i]].size();
+    }
+
+    const lb_grid2_data_t<T>& map = *data.map;
+    unsigned long start_time = utils_get_current_time_us();
+
     for(int n = 0; n < cfg.n_particles; n++) {
-        //predict position
-        data.p_tmp[n].p =
-            lb_odometry_motion_model_sample(odo_pose,
-                                            data.last_odo_pose,
-                                            data.p[n].p,
-                                            cfg.motion_var);
+        data.p_tmp[n].p = data.p[n].p;
+
         //check measurement
         vec2i grid_coor;
-        LB_FLOAT sense_angle = 0;
+        T sense_angle = 0;
         int sense_idx = 0;
         LB_FLOAT zp;
-        if(data.map.get_grid_coordinate(data.p_tmp[n].p.x, data.p_tmp[n].p.y, grid_coor)) {
-            if(data.map.ray_casting_cache[grid_coor.x][grid_coor.y].size() != 0) {
+        if(map.get_grid_coordinate(data.p_tmp[n].p.x, data.p_tmp[n].p.y, grid_coor)) {
+            if(map.ray_casting_cache[grid_coor.x][grid_coor.y].size() != 0) {
                 data.p_tmp[n].w = 1.0;
-                for(size_t i = 0; i < z.size(); i += z_down_sample) {
+                for(size_t i = 0; i < n_beams; i++) {
                 //find nearest measurement in pre-computed ray casting
 
                     //compute sense angle (convert from local coordinate to global coordinate)
-                    sense_angle = lb_normalize_angle(z[i].theta() + data.p_tmp[n].p.a);
+                    sense_angle = lb_normalize_angle_t<T>(data.beam_angle[i] + data.p_tmp[n].p.a);
 
                     //get index
-                    sense_idx = (int)(sense_angle/data.map.angle_res);
-                    if(sense_idx < 0) sense_idx += data.map.angle_step;
+                    sense_idx = (int)(sense_angle/map.angle_res);
+                    if(sense_idx < 0) sense_idx += map.angle_step;
 
                     //compute PDF (can speed up by lookup table)
-                    zp = lb_beam_range_finder_measurement_model(z[i].size(),
-                                                                data.map.ray_casting_cache[grid_coor.x][grid_coor.y][sense_idx],
+                    zp = lb_beam_range_finder_measurement_model(data.beam_range[i],
+                                                                map.ray_casting_cache[grid_coor.x][grid_coor.y][sense_idx],
                                                                 cfg.z_max_range,
                                                                 cfg.z_hit_var,
                                                                 cfg.z_short_rate,
@@ -202,10 +382,151 @@ inline int lb_mcl_grid2_update_with_odomety(const lb_mcl_grid2_configuration& cf
         data.p[n].p = data.p_tmp[n].p;
         data.p[n].w = data.p_tmp[n].w;
     }
+
+    //update cost estimation for the beam budget
+    if((n_beams > 0) && (cfg.n_particles > 0)) {
+        LB_FLOAT cost = (LB_FLOAT)(utils_get_current_time_us() - start_time) / (n_beams * cfg.n_particles);
+        data.beam_cost = (data.beam_cost > 0) ? ((0.8 * data.beam_cost) + (0.2 * cost)) : cost;
+    }
+
+    data.motion_d = data.motion_a = 0;
+    data.force_update = false;
+    data.updated = true;
+    data.update_time = utils_get_current_time_us() - start_time;
+    data.update_evaluations = n_beams * cfg.n_particles;
+    data.n_update++;
+}
+
+/**
+ * Monte Carlo Localization (MCL) in 2D grid map with selected beams.
+ * Prediction and measurement update run only when the odometry moved more than
+ * cfg.update_min_d or cfg.update_min_a since the last update (a threshold of 0 is off,
+ * see lb_mcl_grid2_motion_reached()). Otherwise the call
+ * returns immediately and the motion keeps accumulating for the next update.
+ * Resample only when the update ran (check return value or data.updated).
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param beam_index index of beams in z to use for measurement update
+ * @param odo_pose odometry measurement at current position
+ * @param data MCL2 data structure
+ * @return 1 if the measurement update ran, 0 if it was skipped
+ */
+template<typename T, typename S>
+inline int lb_mcl_grid2_update_with_odomety(const lb_mcl_grid2_configuration& cfg,
+                                            const std::vector<vec2<S> >& z,
+                                            const std::vector<int>& beam_index,
+                                            const pose2f& odo_pose,
+                                            lb_mcl_grid2_data_t<T>& data)
+{
+    data.updated = false;
+    if(!lb_mcl_grid2_need_update(cfg, odo_pose, data)) {
+        data.n_skip++;
+        return 0;
+    }
+
+    //predict position of all particles
+    lb_odometry_motion_model_sample(odo_pose,
+                                    data.last_odo_pose,
+                                    data.p,
+                                    cfg.motion_var,
+                                    data.motion_ws);
+
+    lb_mcl_grid2_measurement_update(cfg, z, beam_index, data);
     data.last_odo_pose = odo_pose;
-    return 0;
+    return 1;
+}
+
+/**
+ * Monte Carlo Localization (MCL) in 2D grid map.
+ * Beams are selected by lb_mcl_grid2_select_beam().
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param odo_pose odometry measurement at current position
+ * @param data MCL2 data structure
+ * @param z_down_sample measurement down sample
+ * @return 1 if the measurement update ran, 0 if it was skipped
+ */
+template<typename T, typename S>
+inline int lb_mcl_grid2_update_with_odomety(const lb_mcl_grid2_configuration& cfg,
+                                            const std::vector<vec2<S> >& z,
+                                            const pose2f& odo_pose,
+                                            lb_mcl_grid2_data_t<T>& data,
+                                            int z_down_sample = 1)
+{
+    if(!lb_mcl_grid2_need_update(cfg, odo_pose, data)) {
+        data.updated = false;
+        data.n_skip++;
+        return 0;
+    }
+    lb_mcl_grid2_select_beam(cfg, z, data, z_down_sample);
+    return lb_mcl_grid2_update_with_odomety(cfg, z, data.beam_index, odo_pose, data);
+}
+
+/**
+ * MCL prediction with velocity motion model, call at control rate.
+ * Particles are moved by the control command only, the sensor update is done
+ * separately by lb_mcl_grid2_update_with_velocity() at scan rate.
+ * @param cfg configuration data (motion_var[0..5])
+ * @param ut control \f$(v, w)^T\f$
+ * @param dt time since the last prediction
+ * @param data MCL2 data structure
+ */
+template<typename T>
+inline void lb_mcl_grid2_predict_with_velocity(const lb_mcl_grid2_configuration& cfg,
+                                               const vec2f& ut,
+                                               LB_FLOAT dt,
+                                               lb_mcl_grid2_data_t<T>& data)
+{
+    if(dt <= 0) return;
+    lb_velocity_motion_model_sample(ut, data.p, dt, cfg.motion_var, data.motion_ws);
+    data.motion_d += fabs(ut.x) * dt;
+    data.motion_a += fabs(ut.y) * dt;
+}
+
+/**
+ * Measurement update for MCL in velocity mode with selected beams.
+ * The particles must already be predicted by lb_mcl_grid2_predict_with_velocity().
+ * The update runs only when the commanded motion since the last update is more than
+ * cfg.update_min_d or cfg.update_min_a (same gate as lb_mcl_grid2_need_update()).
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param beam_index index of beams in z to use for measurement update
+ * @param data MCL2 data structure
+ * @return 1 if the measurement update ran, 0 if it was skipped
+ */
+template<typename T, typename S>
+inline int lb_mcl_grid2_update_with_velocity(const lb_mcl_grid2_configuration& cfg,
+                                             const std::vector<vec2<S> >& z,
+                                             const std::vector<int>& beam_index,
+                                             lb_mcl_grid2_data_t<T>& data)
+{
+    data.updated = false;
+    if(!data.force_update && !lb_mcl_grid2_motion_reached(cfg, data.motion_d, data.motion_a)) {
+        data.n_skip++;
+        return 0;
+    }
+    lb_mcl_grid2_measurement_update(cfg, z, beam_index, data);
+    return 1;
 }
 
+/**
+ * Measurement update for MCL in velocity mode.
+ * Beams are selected by lb_mcl_grid2_select_beam().
+ * @param cfg configuration data
+ * @param z vector relative LRF measurement point
+ * @param data MCL2 data structure
+ * @param z_down_sample measurement down sample
+ * @return 1 if the measurement update ran, 0 if it was skipped
+ */
+template<typename T, typename S>
+inline int lb_mcl_grid2_update_with_velocity(const lb_mcl_grid2_configuration& cfg,
+                                             const std::vector<vec2<S> >& z,
+                                             lb_mcl_grid2_data_t<T>& data,
+                                             int z_down_sample = 1)
+{
+    lb_mcl_grid2_select_beam(cfg, z, data, z_down_sample);
+    return lb_mcl_grid2_update_with_velocity(cfg, z, data.beam_index, data);
+}
 
 
 
@@ -0,0 +1,330 @@
+/*
+ * lb_median_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LB_MEDIAN_FILTER_H_
+#define LB_MEDIAN_FILTER_H_
+
+#include "lb_common.h"
+#include "lb_macro_function.h"
+
+namespace librobotics {
+
+/**
+ * @defgroup median_filter Median filter
+ * 1D median filter with edge replication. Window of 3, 5, 7 and 9 use
+ * sorting networks (branch free, vectorized over the output), larger
+ * windows use a sliding double heap in O(n log w).
+ * @{
+ */
+
+///Compare and exchange, a <= b after the call
+template<typename T>
+inline void lb_cas(T& a, T& b) {
+    T t = LB_MIN(a, b);
+    b = LB_MAX(a, b);
+    a = t;
+}
+
+/**
+ * Median selection networks (N. Devillard, "Fast median search").
+ * median() reorders v and returns the median of W values.
+ */
+template<int W>
+struct lb_median_network;
+
+template<>
+struct lb_median_network<3> {
+    template<typename T>
+    static inline T median(T* p) {
+        lb_cas(p[0], p[1]); lb_cas(p[1], p[2]); lb_cas(p[0], p[1]);
+        return p[1];
+    }
+};
+
+template<>
+struct lb_median_network<5> {
+    template<typename T>
+    static inline T median(T* p) {
+        lb_cas(p[0], p[1]); lb_cas(p[3], p[4]); lb_cas(p[0], p[3]);
+        lb_cas(p[1], p[4]); lb_cas(p[1], p[2]); lb_cas(p[2], p[3]);
+        lb_cas(p[1], p[2]);
+        return p[2];
+    }
+};
+
+template<>
+struct lb_median_network<7> {
+    template<typename T>
+    static inline T median(T* p) {
+        lb_cas(p[0], p[5]); lb_cas(p[0], p[3]); lb_cas(p[1], p[6]);
+        lb_cas(p[2], p[4]); lb_cas(p[0], p[1]); lb_cas(p[3], p[5]);
+        lb_cas(p[2], p[6]); lb_cas(p[2], p[3]); lb_cas(p[3], p[6]);
+        lb_cas(p[4], p[5]); lb_cas(p[1], p[4]); lb_cas(p[1], p[3]);
+        lb_cas(p[3], p[4]);
+        return p[3];
+    }
+};
+
+template<>
+struct lb_median_network<9> {
+    template<typename T>
+    static inline T median(T* p) {
+        lb_cas(p[1], p[2]); lb_cas(p[4], p[5]); lb_cas(p[7], p[8]);
+        lb_cas(p[0], p[1]); lb_cas(p[3], p[4]); lb_cas(p[6], p[7]);
+        lb_cas(p[1], p[2]); lb_cas(p[4], p[5]); lb_cas(p[7], p[8]);
+        lb_cas(p[0], p[3]); lb_cas(p[5], p[8]); lb_cas(p[4], p[7]);
+        lb_cas(p[3], p[6]); lb_cas(p[1], p[4]); lb_cas(p[2], p[5]);
+        lb_cas(p[4], p[7]); lb_cas(p[4], p[2]); lb_cas(p[6], p[4]);
+        lb_cas(p[4], p[2]);
+        return p[4];
+    }
+};
+
+/**
+ * Median filter with a sorting network of window W (3, 5, 7 or 9).
+ * @param in input values
+ * @param out output values (must not alias in)
+ * @param n number of values
+ */
+template<int W, typename T>
+inline void lb_median_filter_network(const T* in, T* out, size_t n) {
+    const int h = W / 2;
+    T v[W];
+
+    //interior without index check
+    for(size_t i = h; i + h < n; i++) {
+        for(int k = 0; k < W; k++) {
+            v[k] = in[i + k - h];
+        }
+        out[i] = lb_median_network<W>::median(v);
+    }
+
+    //edges with replicated values
+    for(size_t i = 0; i < n; i++) {
+        if((i == (size_t)h) && (n > (size_t)(2 * h))) {
+            i = n - h;
+        }
+        for(int k = 0; k < W; k++) {
+            int j = LB_MAX((int)i + k - h, 0);
+            v[k] = in[LB_MIN(j, (int)n - 1)];
+        }
+        out[i] = lb_median_network<W>::median(v);
+    }
+}
+
+/**
+ * Sliding median of a fixed odd window with two heaps.
+ * The lower max-heap holds h + 1 values (median on top), the upper min-heap holds h values.
+ * Replacing the oldest value is O(log w). Storage is kept between calls.
+ */
+template<typename T>
+struct lb_sliding_median_t {
+    std::vector<T> value;           //!< value of each window slot
+    std::vector<int> heap;          //!< slots, lower heap in [0, h], upper heap in [h + 1, w)
+    std::vector<int> pos;           //!< heap index of each slot
+    int h;                          //!< half window
+    int oldest;                     //!< slot to replace next
+
+    lb_sliding_median_t() : h(0), oldest(0) { }
+
+    /**
+     * Initialize the window with values (2h + 1 values).
+     */
+    void init(const T* v, int half_window) {
+        h = half_window;
+        value.assign(v, v + (2 * h) + 1);
+        build();
+    }
+
+    /**
+     * Build the heaps from the current window values (value.size() = 2h + 1).
+     */
+    void build() {
+        int w = value.size();
+        heap.resize(w);
+        pos.resize(w);
+
+        //sort slots once, lower half to max-heap and upper half to min-heap
+        for(int i = 0; i < w; i++) heap[i] = i;
+        std::sort(heap.begin(), heap.end(), slot_less(&value[0]));
+        std::reverse(heap.begin(), heap.begin() + h + 1);   //descending is a valid max-heap
+        for(int i = 0; i < w; i++) pos[heap[i]] = i;
+        oldest = 0;
+    }
+
+    ///Current median
+    inline T median() const {
+        return value[heap[0]];
+    }
+
+    ///Replace the oldest value and return the new median
+    inline T push(T v) {
+        int slot = oldest;
+        oldest = (oldest + 1 == (int)value.size()) ? 0 : (oldest + 1);
+        value[slot] = v;
+        int p = pos[slot];
+        if(p <= h) {
+            lower_up(p);
+            lower_down(pos[slot]);
+        } else {
+            upper_up(p);
+            upper_down(pos[slot]);
+        }
+
+        //restore order between heaps
+        if((h > 0) && (value[heap[h + 1]] < value[heap[0]])) {
+            swap(0, h + 1);
+            lower_down(0);
+            upper_down(h + 1);
+        }
+        return value[heap[0]];
+    }
+
+private:
+    struct slot_less {
+        const T* v;
+        slot_less(const T* _v) : v(_v) { }
+        bool operator()(int a, int b) const { return v[a] < v[b]; }
+    };
+
+    inline void swap(int i, int j) {
+        int t = heap[i];
+        heap[i] = heap[j];
+        heap[j] = t;
+        pos[heap[i]] = i;
+        pos[heap[j]] = j;
+    }
+
+    //lower max-heap, index i in [0, h]
+    inline void lower_up(int i) {
+        while(i > 0) {
+            int parent = (i - 1) >> 1;
+            if(!(value[heap[parent]] < value[heap[i]])) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    inline void lower_down(int i) {
+        int n = h + 1;
+        for(;;) {
+            int c = (2 * i) + 1;
+            if(c >= n) break;
+            if((c + 1 < n) && (value[heap[c]] < value[heap[c + 1]])) c++;
+            if(!(value[heap[i]] < value[heap[c]])) break;
+            swap(i, c);
+            i = c;
+        }
+    }
+
+    //upper min-heap, index i in [h + 1, w), local index i - (h + 1)
+    inline void upper_up(int i) {
+        int b = h + 1;
+        while(i > b) {
+            int parent = b + ((i - b - 1) >> 1);
+            if(!(value[heap[i]] < value[heap[parent]])) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    inline void upper_down(int i) {
+        int b = h + 1;
+        int n = h;
+        for(;;) {
+            int c = (2 * (i - b)) + 1;
+            if(c >= n) break;
+            if((c + 1 < n) && (value[heap[b + c + 1]] < value[heap[b + c]])) c++;
+            c += b;
+            if(!(value[heap[c]] < value[heap[i]])) break;
+            swap(i, c);
+            i = c;
+        }
+    }
+};
+
+/**
+ * Median filter with the sliding double heap, any half window size.
+ * @param in input values
+ * @param out output values (must not alias in)
+ * @param n number of values
+ * @param half_window half window size
+ * @param ws sliding median storage (reused between calls)
+ */
+template<typename T>
+inline void lb_median_filter_heap(const T* in, T* out, size_t n, int half_window,
+                                  lb_sliding_median_t<T>& ws)
+{
+    if(n == 0) return;
+
+    //first window centered at 0
+    int w = (2 * half_window) + 1;
+    ws.h = half_window;
+    ws.value.resize(w);
+    for(int k = 0; k < w; k++) {
+        ws.value[k] = in[LB_MIN((size_t)LB_MAX(k - half_window, 0), n - 1)];
+    }
+    ws.build();
+    out[0] = ws.median();
+    for(size_t i = 1; i < n; i++) {
+        out[i] = ws.push(in[LB_MIN(i + half_window, n - 1)]);
+    }
+}
+
+/**
+ * Median filter with edge replication, selects network or double heap by window.
+ * @param in input values
+ * @param out output values (must not alias in)
+ * @param n number of values
+ * @param half_window half window size
+ * @param ws sliding median storage for large windows (reused between calls)
+ */
+template<typename T>
+inline void lb_median_filter(const T* in, T* out, size_t n, int half_window,
+                             lb_sliding_median_t<T>& ws)
+{
+    switch(half_window) {
+        case 0:
+            std::copy(in, in + n, out);
+            break;
+        case 1: lb_median_filter_network<3>(in, out, n); break;
+        case 2: lb_median_filter_network<5>(in, out, n); break;
+        case 3: lb_median_filter_network<7>(in, out, n); break;
+        case 4: lb_median_filter_network<9>(in, out, n); break;
+        default:
+            lb_median_filter_heap(in, out, n, half_window, ws);
+            break;
+    }
+}
+
+/* @} */
+
+}
+
+#endif /* LB_MEDIAN_FILTER_H_ */
@@ -32,6 +32,9 @@
 
 #include "lb_common.h"
 #include "lb_data_type.h"
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
 
 namespace librobotics {
 
@@ -79,19 +82,31 @@ inline void lb_build_cos_sin_table(const std::vector<LB_FLOAT>& angle_table,
 }
 
 /**
- * Normalize the angle to \f$(-\pi, \pi)\f$ radian unit
+ * Normalize the angle to \f$[-\pi, \pi)\f$ radian unit.
+ * Branch free (floor is a single rounding instruction), vectorizable in loops.
  * \param a input angle value
  * \return normalized angle
  */
 
 inline LB_FLOAT lb_normalize_angle(LB_FLOAT a) {
-    int m = (int)(a / (2.0*M_PI));
-    a = a - (m * M_PI * 2.0);
-    if (a < (-M_PI))
-        a += (2.0 * M_PI);
-    if (a >= M_PI)
-        a -= (2.0 * M_PI);
-    return a;
+    return a - ((2.0 * M_PI) * floor(a * (0.5 / M_PI) + 0.5));
+}
+
+/**
+ * lb_normalize_angle() in the precision of T (float or double), for code templated
+ * on the scalar type so float paths do not round trip through double.
+ * \param a input angle value
+ * \return normalized angle in [-pi, pi), pi rounded to T
+ */
+template<typename T>
+inline T lb_normalize_angle_t(T a) {
+    BOOST_STATIC_ASSERT(boost::is_floating_point<T>::value);
+    const T two_pi = (T)(2.0 * M_PI);
+    T k = std::floor(a * (T)(0.5 / M_PI) + (T)0.5);
+    T r = a - (two_pi * k);
+    //rounding in T can step over -pi or reach pi
+    r = (r < -(T)M_PI) ? (r + two_pi) : r;
+    return (r >= (T)M_PI) ? (r - two_pi) : r;
 }
 
 /**
@@ -102,18 +117,70 @@ inline LB_FLOAT lb_normalize_angle(LB_FLOAT a) {
  */
 
 inline LB_FLOAT lb_minimum_angle_distance(LB_FLOAT a, LB_FLOAT b) {
-    a = lb_normalize_angle(a);
-    b = lb_normalize_angle(b);
+    return lb_normalize_angle(b - a);
+}
 
-    LB_FLOAT diff = b - a;
+///lb_minimum_angle_distance() in the precision of T (float or double)
+template<typename T>
+inline T lb_minimum_angle_distance_t(T a, T b) {
+    return lb_normalize_angle_t<T>(b - a);
+}
 
-    if(fabs(diff) > M_PI) {
-        if(diff < 0)
-            diff += (2 * M_PI);
-        else
-            diff -= (2 * M_PI);
-    }
-    return diff;
+
+/**
+ * Index of the lowest set bit (count trailing zero), x must not be 0.
+ * \param x input value
+ * \return bit index (0..63)
+ */
+inline int lb_ctz64(boost::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    //de Bruijn multiplication
+    static const int table[64] = {
+        63,  0, 58,  1, 59, 47, 53,  2, 60, 39, 48, 27, 54, 33, 42,  3,
+        61, 51, 37, 40, 49, 18, 28, 20, 55, 30, 34, 11, 43, 14, 22,  4,
+        62, 57, 46, 52, 38, 26, 32, 41, 50, 36, 17, 19, 29, 10, 13, 21,
+        56, 45, 25, 31, 35, 16,  9, 12, 44, 24, 15,  8, 23,  7,  6,  5
+    };
+    return table[((x & (~x + 1)) * 0x07EDD5E59A4E28C2ULL) >> 58];
+#endif
+}
+
+/**
+ * Index of the highest set bit, x must not be 0.
+ * \param x input value
+ * \return bit index (0..63)
+ */
+inline int lb_bsr64(boost::uint64_t x) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(x);
+#else
+    int r = 0;
+    if(x >> 32) { x >>= 32; r += 32; }
+    if(x >> 16) { x >>= 16; r += 16; }
+    if(x >> 8) { x >>= 8; r += 8; }
+    if(x >> 4) { x >>= 4; r += 4; }
+    if(x >> 2) { x >>= 2; r += 2; }
+    if(x >> 1) { r += 1; }
+    return r;
+#endif
+}
+
+/**
+ * Number of set bits.
+ * \param x input value
+ * \return number of set bits
+ */
+inline int lb_popcount64(boost::uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
 }
 
 
@@ -53,5 +53,13 @@ typedef double  LB_FLOAT;
 #define librobotics_use_opengl      0
 #endif
 
+#ifndef librobotics_use_fast_math
+#define librobotics_use_fast_math   0
+#endif
+
+#ifndef librobotics_use_openmp
+#define librobotics_use_openmp      0
+#endif
+
 
 #endif /* LB_OPTION_H_ */
@@ -0,0 +1,354 @@
+/*
+ * lb_random.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LB_RANDOM_H_
+#define LB_RANDOM_H_
+
+#include "lb_common.h"
+#include "lb_tools.h"
+#include <boost/cstdint.hpp>
+
+namespace librobotics {
+
+/**
+ * SplitMix64 step, used to expand a seed into engine state.
+ * @param x seed state (updated)
+ * @return next 64 bit value
+ */
+inline boost::uint64_t lb_splitmix64(boost::uint64_t& x) {
+    boost::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+inline boost::uint64_t lb_rotl64(const boost::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Convert random bits to \f$[0,1)\f$ double without integer to float conversion
+ * (use the upper 52 bits as mantissa, vectorized well).
+ */
+inline double lb_u64_to_unit(const boost::uint64_t x) {
+    union { boost::uint64_t i; double d; } u;
+    u.i = (x >> 12) | 0x3FF0000000000000ULL;
+    return u.d - 1.0;
+}
+
+/**
+ * xoshiro256+ random engine (http://prng.di.unimi.it/).
+ * Plain data type, so it can be stored per thread (librobotics_tls) or per stream.
+ * Any engine with the same next() interface can be used with the sampling functions.
+ */
+struct lb_rng_xoshiro256p {
+    boost::uint64_t s[4];
+
+    ///Seed the state from a single value
+    void seed(boost::uint64_t x) {
+        for(int i = 0; i < 4; i++) {
+            s[i] = lb_splitmix64(x);
+        }
+    }
+
+    ///Next 64 random bits
+    boost::uint64_t next() {
+        const boost::uint64_t result = s[0] + s[3];
+        const boost::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = lb_rotl64(s[3], 45);
+        return result;
+    }
+
+    ///Uniform \f$[0,1)\f$
+    double uniform() {
+        return lb_u64_to_unit(next());
+    }
+
+    /**
+     * Advance the state by \f$2^{128}\f$ steps.
+     * Use to create non-overlapping streams from the same seed.
+     */
+    void jump() {
+        static const boost::uint64_t JUMP[] = {
+            0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+            0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+        boost::uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for(int i = 0; i < 4; i++) {
+            for(int b = 0; b < 64; b++) {
+                if(JUMP[i] & (1ULL << b)) {
+                    s0 ^= s[0];
+                    s1 ^= s[1];
+                    s2 ^= s[2];
+                    s3 ^= s[3];
+                }
+                next();
+            }
+        }
+        s[0] = s0; s[1] = s1; s[2] = s2; s[3] = s3;
+    }
+};
+
+typedef lb_rng_xoshiro256p lb_rng;
+
+/**
+ * Four interleaved xoshiro256+ lanes in SoA layout for batch generation.
+ * The lane update is plain 64 bit integer code that compilers vectorize (SSE2/AVX2/NEON).
+ */
+struct lb_rng_x4 {
+    boost::uint64_t s0[4], s1[4], s2[4], s3[4];
+    lb_rng tail;                    //!< scalar engine for rejection paths
+
+    ///Seed all lanes (each lane is a jumped stream of the same seed)
+    void seed(boost::uint64_t x) {
+        tail.seed(x);
+        for(int l = 0; l < 4; l++) {
+            tail.jump();
+            s0[l] = tail.s[0];
+            s1[l] = tail.s[1];
+            s2[l] = tail.s[2];
+            s3[l] = tail.s[3];
+        }
+        tail.jump();
+    }
+
+    ///Next 4x64 random bits
+    void next(boost::uint64_t r[4]) {
+        for(int l = 0; l < 4; l++) {
+            r[l] = s0[l] + s3[l];
+            const boost::uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+        }
+    }
+};
+
+/**
+ * Ziggurat tables (128 layers, Marsaglia & Tsang 2000), built once and read-only.
+ */
+struct lb_ziggurat_table {
+    boost::uint32_t kn[128];
+    double wn[128];
+    double fn[128];
+
+    lb_ziggurat_table() {
+        const double m1 = 2147483648.0;
+        const double vn = 9.91256303526217e-3;
+        double dn = 3.442619855899;
+        double tn = dn;
+        double q = vn / exp(-0.5 * dn * dn);
+
+        kn[0] = (boost::uint32_t)((dn / q) * m1);
+        kn[1] = 0;
+        wn[0] = q / m1;
+        wn[127] = dn / m1;
+        fn[0] = 1.0;
+        fn[127] = exp(-0.5 * dn * dn);
+        for(int i = 126; i >= 1; i--) {
+            dn = sqrt(-2.0 * log((vn / dn) + exp(-0.5 * dn * dn)));
+            kn[i + 1] = (boost::uint32_t)((dn / tn) * m1);
+            tn = dn;
+            fn[i] = exp(-0.5 * dn * dn);
+            wn[i] = dn / m1;
+        }
+    }
+
+    static const lb_ziggurat_table& get() {
+        static const lb_ziggurat_table table;
+        return table;
+    }
+};
+
+/**
+ * Tail and wedge part of the ziggurat sampler (about 1.2% of samples)
+ */
+template<typename R>
+inline double lb_ziggurat_normal_slow(R& rng, boost::int32_t hz, int iz) {
+    const lb_ziggurat_table& t = lb_ziggurat_table::get();
+    const double r = 3.442619855899;
+    double x, y;
+    for(;;) {
+        x = hz * t.wn[iz];
+        if(iz == 0) {
+            //tail
+            do {
+                x = -log(1.0 - rng.uniform()) / r;
+                y = -log(1.0 - rng.uniform());
+            } while((y + y) < (x * x));
+            return (hz > 0) ? (r + x) : (-r - x);
+        }
+        //wedge
+        if((t.fn[iz] + (rng.uniform() * (t.fn[iz - 1] - t.fn[iz]))) < exp(-0.5 * x * x))
+            return x;
+
+        boost::uint64_t u = rng.next();
+        iz = (int)(u & 127);
+        hz = (boost::int32_t)(u >> 32);
+        boost::uint32_t ahz = (hz < 0) ? (boost::uint32_t)(-(boost::int64_t)hz) : (boost::uint32_t)hz;
+        if(ahz < t.kn[iz])
+            return hz * t.wn[iz];
+    }
+}
+
+/**
+ * Sample from standard normal distribution with the ziggurat method.
+ * Layer index and value come from independent bits of one 64 bit draw.
+ * @param rng random engine
+ * @return N(0,1) sample
+ */
+template<typename R>
+inline double lb_ziggurat_normal(R& rng) {
+    const lb_ziggurat_table& t = lb_ziggurat_table::get();
+    boost::uint64_t u = rng.next();
+    int iz = (int)(u & 127);
+    boost::int32_t hz = (boost::int32_t)(u >> 32);
+    boost::uint32_t ahz = (hz < 0) ? (boost::uint32_t)(-(boost::int64_t)hz) : (boost::uint32_t)hz;
+    if(ahz < t.kn[iz])
+        return hz * t.wn[iz];
+    return lb_ziggurat_normal_slow(rng, hz, iz);
+}
+
+/**
+ * Seed value from time, thread local address and a call counter.
+ */
+inline boost::uint64_t lb_rng_auto_seed(const void* p) {
+    static librobotics_tls boost::uint64_t counter = 0;
+    boost::uint64_t x = ((boost::uint64_t)utils_get_current_time_us() << 20) ^
+                        (boost::uint64_t)(size_t)p ^
+                        (counter++ * 0x9E3779B97F4A7C15ULL);
+    return lb_splitmix64(x);
+}
+
+inline bool& lb_rng_default_seeded() {
+    static librobotics_tls bool seeded = false;
+    return seeded;
+}
+
+/**
+ * Random engine of the calling thread, used by all sampling functions without
+ * an explicit engine. Seeded automatically on first use or with lb_srand(seed).
+ */
+inline lb_rng& lb_rng_default() {
+    static librobotics_tls lb_rng rng;
+    if(!lb_rng_default_seeded()) {
+        rng.seed(lb_rng_auto_seed(&rng));
+        lb_rng_default_seeded() = true;
+    }
+    return rng;
+}
+
+inline bool& lb_rng_x4_default_seeded() {
+    static librobotics_tls bool seeded = false;
+    return seeded;
+}
+
+/**
+ * Batch random engine of the calling thread (seeded from lb_rng_default()).
+ */
+inline lb_rng_x4& lb_rng_x4_default() {
+    static librobotics_tls lb_rng_x4 rng;
+    if(!lb_rng_x4_default_seeded()) {
+        rng.seed(lb_rng_default().next());
+        lb_rng_x4_default_seeded() = true;
+    }
+    return rng;
+}
+
+/**
+ * Fill array with uniform \f$[0,1)\f$ random value.
+ * @param rng batch random engine
+ * @param v output
+ * @param n number of value
+ */
+template<typename T>
+inline void lb_rand_fill(lb_rng_x4& rng, T* v, size_t n) {
+    boost::uint64_t r[4];
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        rng.next(r);
+        for(int l = 0; l < 4; l++) {
+            v[i + l] = (T)lb_u64_to_unit(r[l]);
+        }
+    }
+    if(i < n) {
+        rng.next(r);
+        for(size_t l = 0; l < n - i; l++) {
+            v[i + l] = (T)lb_u64_to_unit(r[l]);
+        }
+    }
+}
+
+template<typename T>
+inline void lb_rand_fill(T* v, size_t n) {
+    lb_rand_fill(lb_rng_x4_default(), v, n);
+}
+
+/**
+ * Fill array with normal distribution random value with zero mean.
+ * Random bits are generated 4 lanes at a time, the ziggurat fast path
+ * is a table lookup and multiply.
+ * @param rng batch random engine
+ * @param v output
+ * @param n number of value
+ * @param sd standard deviation
+ */
+template<typename T>
+inline void lb_sample_normal_dist_fill(lb_rng_x4& rng, T* v, size_t n, LB_FLOAT sd = 1.0) {
+    const lb_ziggurat_table& t = lb_ziggurat_table::get();
+    boost::uint64_t r[4];
+    for(size_t i = 0; i < n; i += 4) {
+        rng.next(r);
+        size_t m = LB_MIN(n - i, (size_t)4);
+        for(size_t l = 0; l < m; l++) {
+            int iz = (int)(r[l] & 127);
+            boost::int32_t hz = (boost::int32_t)(r[l] >> 32);
+            boost::uint32_t ahz = (hz < 0) ? (boost::uint32_t)(-(boost::int64_t)hz) : (boost::uint32_t)hz;
+            double x = (ahz < t.kn[iz]) ? (hz * t.wn[iz]) : lb_ziggurat_normal_slow(rng.tail, hz, iz);
+            v[i + l] = (T)(x * sd);
+        }
+    }
+}
+
+template<typename T>
+inline void lb_sample_normal_dist_fill(T* v, size_t n, LB_FLOAT sd = 1.0) {
+    lb_sample_normal_dist_fill(lb_rng_x4_default(), v, n, sd);
+}
+
+}
+
+#endif /* LB_RANDOM_H_ */
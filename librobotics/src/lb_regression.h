@@ -31,18 +31,28 @@
 #define LB_REGRESSION_H_
 
 #include "lb_common.h"
+#include "lb_exception.h"
 #include "lb_data_type.h"
 
 
 namespace librobotics {
 
+/**
+ * Line through the first and last point, \f$Ax+By+C=0\f$.
+ * @param points points
+ * @param n number of points (> 0)
+ * @param a A
+ * @param b B
+ * @param c C
+ */
 template<typename T>
-void lb_line_define(const std::vector<vec2<T> >& points,
+void lb_line_define(const vec2<T>* points,
+                    size_t n,
                     LB_FLOAT &a,
                     LB_FLOAT &b,
                     LB_FLOAT &c)
 {
-    size_t end_idx = points.size() - 1;
+    size_t end_idx = n - 1;
 
     //Ax+By+C=0
     LB_FLOAT m1,m2;
@@ -55,12 +65,29 @@ void lb_line_define(const std::vector<vec2<T> >& points,
 }
 
 template<typename T>
-inline void lb_liner_regression(const std::vector<vec2<T> >& points,
+void lb_line_define(const std::vector<vec2<T> >& points,
+                    LB_FLOAT &a,
+                    LB_FLOAT &b,
+                    LB_FLOAT &c)
+{
+    lb_line_define(&points[0], points.size(), a, b, c);
+}
+
+/**
+ * Total least squares line \f$y = mx + b\f$ of points, r is the maximum point to line distance.
+ * @param points points
+ * @param n number of points
+ * @param m slope
+ * @param b intercept
+ * @param r maximum error
+ */
+template<typename T>
+inline void lb_liner_regression(const vec2<T>* points,
+                                size_t n,
                                 LB_FLOAT& m,
                                 LB_FLOAT& b,
                                 LB_FLOAT& r)
 {
-    size_t n = points.size();
     if(n > 0) {
         LB_FLOAT sum_x = 0;
         LB_FLOAT sum_y = 0;
@@ -72,19 +99,13 @@ inline void lb_liner_regression(const std::vector<vec2<T> >& points,
         LB_FLOAT mean_x = sum_x / n;
         LB_FLOAT mean_y = sum_y / n;
 
-        std::vector<LB_FLOAT> x_err(n, 0);
-        std::vector<LB_FLOAT> y_err(n, 0);
-
-        for(size_t i = 0; i < n; i++) {
-            x_err[i] = points[i].x - mean_x;
-            y_err[i] = points[i].y - mean_y;
-        }
-
         LB_FLOAT A = 0;
         LB_FLOAT sum_err_xy = 0;
         for (size_t i = 0; i < n; i++) {
-            A = A + (LB_SQR(x_err[i]) - LB_SQR(y_err[i]));
-            sum_err_xy += (x_err[i] * y_err[i]);
+            LB_FLOAT x_err = points[i].x - mean_x;
+            LB_FLOAT y_err = points[i].y - mean_y;
+            A = A + (LB_SQR(x_err) - LB_SQR(y_err));
+            sum_err_xy += (x_err * y_err);
         }
 
         if (sum_err_xy == 0)
@@ -136,6 +157,146 @@ inline void lb_liner_regression(const std::vector<vec2<T> >& points,
     }
 }
 
+template<typename T>
+inline void lb_liner_regression(const std::vector<vec2<T> >& points,
+                                LB_FLOAT& m,
+                                LB_FLOAT& b,
+                                LB_FLOAT& r)
+{
+    if(points.empty()) {
+        m = b = r = 0;
+        debug("%s number of point == 0", __FUNCTION__);
+        return;
+    }
+    lb_liner_regression(&points[0], points.size(), m, b, r);
+}
+
+
+/**
+ * Maximum point to line distance of points to y = mx + b.
+ * @param points points
+ * @param n number of points
+ * @param m slope
+ * @param b intercept
+ * @return maximum distance
+ */
+template<typename T>
+inline LB_FLOAT lb_line_max_residual(const vec2<T>* points,
+                                     size_t n,
+                                     const LB_FLOAT m,
+                                     const LB_FLOAT b)
+{
+    //single pass, the max reduction vectorizes with -ffinite-math-only -fno-signed-zeros (-ffast-math)
+    LB_FLOAT r = 0;
+    for(size_t i = 0; i < n; i++) {
+        LB_FLOAT d = fabs(m*points[i].x - points[i].y + b);
+        r = (d > r) ? d : r;
+    }
+    return r / sqrt(m*m + 1);
+}
+
+/**
+ * Prefix sums of point moments (x, y, xx, xy, yy), built once for a point list.
+ * Total least squares line of any index range [begin, end) is then O(1).
+ * Moments are taken relative to the first point and kept in double, so the
+ * difference of two prefix sums is still accurate for short ranges.
+ */
+template<typename T>
+struct lb_line_moment_table {
+    vec2<T> origin;
+    std::vector<double> sx, sy, sxx, sxy, syy;
+
+    size_t size() const { return sx.empty() ? 0 : sx.size() - 1; }
+
+    void build(const vec2<T>* points, size_t n) {
+        sx.resize(n + 1); sy.resize(n + 1);
+        sxx.resize(n + 1); sxy.resize(n + 1); syy.resize(n + 1);
+        sx[0] = sy[0] = sxx[0] = sxy[0] = syy[0] = 0;
+        if(n == 0) return;
+
+        origin = points[0];
+        for(size_t i = 0; i < n; i++) {
+            double x = points[i].x - origin.x;
+            double y = points[i].y - origin.y;
+            sx[i + 1] = sx[i] + x;
+            sy[i + 1] = sy[i] + y;
+            sxx[i + 1] = sxx[i] + x*x;
+            sxy[i + 1] = sxy[i] + x*y;
+            syy[i + 1] = syy[i] + y*y;
+        }
+    }
+
+    void build(const std::vector<vec2<T> >& points) {
+        if(points.empty()) build((const vec2<T>*)0, 0);
+        else build(&points[0], points.size());
+    }
+
+    /**
+     * Line y = mx + b of points [begin, end).
+     * From the two roots of m^2 + Am - 1 = 0 (as lb_liner_regression()), the one
+     * with the smaller sum of squared point to line distance is used.
+     * @return false if the range is empty
+     */
+    bool fit(size_t begin, size_t end, LB_FLOAT& m, LB_FLOAT& b) const {
+        if(end > size() || begin > end) {
+            throw LibRoboticsRuntimeException("%s: range [%d, %d) out of %d", __FUNCTION__, (int)begin, (int)end, (int)size());
+        }
+        if(begin == end) {
+            m = b = 0;
+            return false;
+        }
+
+        double n = (double)(end - begin);
+        double mean_x = (sx[end] - sx[begin]) / n;
+        double mean_y = (sy[end] - sy[begin]) / n;
+        double cxx = (sxx[end] - sxx[begin]) - n * mean_x * mean_x;
+        double cxy = (sxy[end] - sxy[begin]) - n * mean_x * mean_y;
+        double cyy = (syy[end] - syy[begin]) - n * mean_y * mean_y;
+
+        if(cxy == 0)
+            cxy = 1e-6;
+        double A = (cxx - cyy) / cxy;
+        double m1 = (-A + sqrt(A*A + 4)) * 0.5;
+        double m2 = (-A - sqrt(A*A + 4)) * 0.5;
+
+        //(sum of squared distance) * (1 + m^2)
+        double e1 = (cyy - 2*m1*cxy + m1*m1*cxx) / (1 + m1*m1);
+        double e2 = (cyy - 2*m2*cxy + m2*m2*cxx) / (1 + m2*m2);
+        double mm = (e1 > e2) ? m2 : m1;
+
+        m = (LB_FLOAT)mm;
+        b = (LB_FLOAT)((mean_y + origin.y) - mm * (mean_x + origin.x));
+        return true;
+    }
+};
+
+/**
+ * Linear regression of points [begin, end) with a moment table built on the same points.
+ * Same output as lb_liner_regression(), fit is O(1) and r is a single pass.
+ * @param table moment table of points
+ * @param points points
+ * @param begin first point
+ * @param end last point + 1
+ * @param m slope
+ * @param b intercept
+ * @param r maximum point to line distance
+ */
+template<typename T>
+inline void lb_liner_regression(const lb_line_moment_table<T>& table,
+                                const vec2<T>* points,
+                                size_t begin,
+                                size_t end,
+                                LB_FLOAT& m,
+                                LB_FLOAT& b,
+                                LB_FLOAT& r)
+{
+    if(!table.fit(begin, end, m, b)) {
+        m = b = r = 0;
+        debug("%s number of point == 0", __FUNCTION__);
+        return;
+    }
+    r = lb_line_max_residual(points + begin, end - begin, m, b);
+}
 
 }
 
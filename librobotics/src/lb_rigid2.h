@@ -0,0 +1,182 @@
+/*
+ * lb_rigid2.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Copyright (c) <2026> <agent>
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LB_RIGID2_H_
+#define LB_RIGID2_H_
+
+#include "lb_common.h"
+#include "lb_macro_function.h"
+#include "lb_vec2.h"
+#include "lb_pose2.h"
+
+namespace librobotics {
+    /**
+     * Template class for 2D rigid transform (rotation then translation).
+     * Built from a pose2 (the pose of a child frame in its parent frame), cos/sin of
+     * the angle are computed once. Transforms are composed with operator *, so a chain
+     * like sensor to robot to world costs one rotation per point.
+     */
+    template<typename T>
+    struct rigid2 {
+        T c;    //!< cos of rotation
+        T s;    //!< sin of rotation
+        T x;    //!< X translation
+        T y;    //!< Y translation
+
+        ///Constructor (identity)
+        rigid2() : c(1), s(0), x(0), y(0)
+        { }
+
+        ///Constructor
+        rigid2(const T cc, const T ss, const T xx, const T yy) :
+            c(cc), s(ss), x(xx), y(yy)
+        { }
+
+        ///Constructor from pose (child frame pose in parent frame)
+        template<typename T1>
+        explicit rigid2(const pose2<T1>& p) :
+            c((T)cos(p.a)), s((T)sin(p.a)), x((T)p.x), y((T)p.y)
+        { }
+
+        ///Copy constructor
+        template<typename T1>
+        rigid2(const rigid2<T1>& r) :
+            c((T)r.c), s((T)r.s), x((T)r.x), y((T)r.y)
+        { }
+
+        ///Pure rotation
+        static rigid2 rotation(const LB_FLOAT angle) {
+            return rigid2((T)cos(angle), (T)sin(angle), 0, 0);
+        }
+
+        ///Composition, (a * b).apply(p) == a.apply(b.apply(p))
+        rigid2 operator * (const rigid2& r) const {
+            return rigid2((c * r.c) - (s * r.s),
+                          (s * r.c) + (c * r.s),
+                          (c * r.x) - (s * r.y) + x,
+                          (s * r.x) + (c * r.y) + y);
+        }
+
+        ///Inverse transform
+        rigid2 inverse() const {
+            return rigid2(c, -s, -((c * x) + (s * y)), (s * x) - (c * y));
+        }
+
+        ///Get transform as pose
+        pose2<T> get_pose2() const {
+            return pose2<T>(x, y, (T)atan2(s, c));
+        }
+
+        ///Transform a point
+        template<typename T1>
+        vec2<T1> apply(const vec2<T1>& p) const {
+            return vec2<T1>((T1)((c * p.x) - (s * p.y) + x),
+                            (T1)((s * p.x) + (c * p.y) + y));
+        }
+
+        ///Rotate a vector (no translation)
+        template<typename T1>
+        vec2<T1> apply_rotation(const vec2<T1>& p) const {
+            return vec2<T1>((T1)((c * p.x) - (s * p.y)),
+                            (T1)((s * p.x) + (c * p.y)));
+        }
+
+        /// support for output stream
+        friend std::ostream& operator << (std::ostream& os, const rigid2<T>& r) {
+            return os << r.x << " " << r.y << " " << atan2(r.s, r.c);
+        }
+    };
+
+    /**
+     * Transform n points in SoA layout, (ox, oy) may be the same arrays as (x, y).
+     * The loop has no branch and no call, so it vectorizes.
+     */
+    template<typename T, typename F>
+    inline void lb_rigid2_apply(const rigid2<T>& t,
+                                const F* x,
+                                const F* y,
+                                F* ox,
+                                F* oy,
+                                const size_t n)
+    {
+        const F c = (F)t.c, s = (F)t.s, tx = (F)t.x, ty = (F)t.y;
+        for(size_t i = 0; i < n; i++) {
+            F px = x[i];
+            F py = y[i];
+            ox[i] = (c * px) - (s * py) + tx;
+            oy[i] = (s * px) + (c * py) + ty;
+        }
+    }
+
+    /**
+     * Transform n points in AoS layout, out may be the same array as in.
+     * If keep_zero is set, (0, 0) points (no measurement) stay (0, 0).
+     */
+    template<typename T, typename F>
+    inline void lb_rigid2_apply(const rigid2<T>& t,
+                                const vec2<F>* in,
+                                vec2<F>* out,
+                                const size_t n,
+                                const bool keep_zero = false)
+    {
+        const F c = (F)t.c, s = (F)t.s, tx = (F)t.x, ty = (F)t.y;
+        if(keep_zero) {
+            for(size_t i = 0; i < n; i++) {
+                F px = in[i].x;
+                F py = in[i].y;
+                F m = ((px != 0) || (py != 0)) ? (F)1 : (F)0;
+                out[i].x = ((c * px) - (s * py) + tx) * m;
+                out[i].y = ((s * px) + (c * py) + ty) * m;
+            }
+        } else {
+            for(size_t i = 0; i < n; i++) {
+                F px = in[i].x;
+                F py = in[i].y;
+                out[i].x = (c * px) - (s * py) + tx;
+                out[i].y = (s * px) + (c * py) + ty;
+            }
+        }
+    }
+
+    ///Transform points (result is resized to points.size())
+    template<typename T, typename F>
+    inline void lb_rigid2_apply(const rigid2<T>& t,
+                                const std::vector<vec2<F> >& points,
+                                std::vector<vec2<F> >& result,
+                                const bool keep_zero = false)
+    {
+        size_t n = points.size();
+        result.resize(n);
+        if(n == 0) return;
+        lb_rigid2_apply(t, &points[0], &result[0], n, keep_zero);
+    }
+}
+
+#endif /* LB_RIGID2_H_ */
@@ -33,6 +33,7 @@
 #include "lb_common.h"
 #include "lb_macro_function.h"
 #include "lb_tools.h"
+#include "lb_random.h"
 
 namespace librobotics {
 
@@ -74,81 +75,138 @@ inline LB_FLOAT lb_pdf_exponential_dist(LB_FLOAT rate, LB_FLOAT x) {
 }
 
 /**
- * Use a specific srand initialization to avoid multi-threading problems
- * (executed only one time for a single program).
+ * Seed the random engine of the calling thread from time
+ * (executed only one time for each thread, no effect after lb_srand(seed)).
  */
 inline void  lb_srand() {
-    static bool first_run = true;
-    if(first_run) {
-        std::srand(utils_get_current_time());
-        unsigned char *const rand_mem = new unsigned char[1+std::rand()%2048];
-        std::srand((unsigned int)(std::rand() + (unsigned long)rand_mem));
-        delete[] rand_mem;
-        first_run = false;
-    }
+    lb_rng_default();
+}
+
+/**
+ * Seed the random engine of the calling thread for repeatable sequences.
+ * @param seed seed value
+ */
+inline void lb_srand(boost::uint64_t seed) {
+    lb_rng_default().seed(seed);
+    lb_rng_default_seeded() = true;
+    lb_rng_x4_default().seed(lb_rng_default().next());
 }
 
 /**
- * Return a random variable between \f$[0,1]\f$ with respect to an uniform distribution.
+ * Return a random variable between \f$[0,1)\f$ with respect to an uniform distribution.
+ * @param rng random engine
+ */
+template<typename R>
+inline LB_FLOAT lb_rand(R& rng) {
+    return (LB_FLOAT)rng.uniform();
+}
+
+/**
+ * Return a random variable between \f$[0,1)\f$ with respect to an uniform distribution.
  */
 inline LB_FLOAT lb_rand() {
-    return (LB_FLOAT)std::rand()/RAND_MAX;
+    return lb_rand(lb_rng_default());
+}
+
+/**
+ * Return a random variable between \f$(-1,1]\f$ with respect to an uniform distribution.
+ * @param rng random engine
+ */
+template<typename R>
+inline LB_FLOAT lb_crand(R& rng) {
+    return 1.0 - (2.0 * lb_rand(rng));
 }
 
 /**
- * Return a random variable between \f$[-1,1]\f$ with respect to an uniform distribution.
+ * Return a random variable between \f$(-1,1]\f$ with respect to an uniform distribution.
  */
 inline LB_FLOAT lb_crand() {
-    return 1.0 - (2.0 * lb_rand());
+    return lb_crand(lb_rng_default());
 }
 
 /**
- * Sample a random value from (approximate) normal distribution with zero mean.
- * @param v variance
+ * Sample a random value from normal distribution with zero mean (ziggurat method).
+ * @param v standard deviation
+ * @param rng random engine
+ * @return random sample from normal distribution with zero mean
+ */
+template<typename R>
+inline LB_FLOAT lb_sample_normal_dist(LB_FLOAT v, R& rng) {
+    return (LB_FLOAT)(v * lb_ziggurat_normal(rng));
+}
+
+/**
+ * Sample a random value from normal distribution with zero mean (ziggurat method).
+ * @param v standard deviation
  * @return random sample from normal distribution with zero mean
  */
 inline LB_FLOAT lb_sample_normal_dist(LB_FLOAT v) {
-    lb_srand();
-    LB_FLOAT sum = 0;
-    for(int i = 0; i < 12; i++) {
-        sum += (lb_crand() * v);
-    }
-    return sum/2.0;
+    return lb_sample_normal_dist(v, lb_rng_default());
 }
 
 /**
  * Sample a random value from (approximate) triangular distribution with zero mean.
  * @param v variance
+ * @param rng random engine
  * @return random sample from triangular distribution with zero mean
  */
-inline LB_FLOAT lb_sample_triangular_dist(LB_FLOAT v) {
+template<typename R>
+inline LB_FLOAT lb_sample_triangular_dist(LB_FLOAT v, R& rng) {
     //SQRT(6) / 2 = 1.224744871
-    lb_srand();
-    return 1.224744871 * ((lb_crand()*v) +  (lb_crand()*v));
+    return 1.224744871 * ((lb_crand(rng)*v) +  (lb_crand(rng)*v));
+}
+
+/**
+ * Sample a random value from (approximate) triangular distribution with zero mean.
+ * @param v variance
+ * @return random sample from triangular distribution with zero mean
+ */
+inline LB_FLOAT lb_sample_triangular_dist(LB_FLOAT v) {
+    return lb_sample_triangular_dist(v, lb_rng_default());
 }
 
 /**
  * Sample a random value from uniform distribution in a circle.
  * (http://www.comnets.uni-bremen.de/itg/itgfg521/per_eval/p001.html)
  * @param a angle result \f$[-\pi, \pi]\f$
- * @param r radius result \f$[-1, 1]\f$
+ * @param r radius result \f$[0, 1]\f$
+ * @param rng random engine
  */
-inline void lb_sample_circle_uniform_dist(LB_FLOAT& a, LB_FLOAT& r) {
-    lb_srand();
-    a = lb_crand() * M_PI;
-    r = sqrt(lb_rand());
+template<typename R>
+inline void lb_sample_circle_uniform_dist(LB_FLOAT& a, LB_FLOAT& r, R& rng) {
+    a = lb_crand(rng) * M_PI;
+    r = sqrt(lb_rand(rng));
 }
 
+/**
+ * Sample a random value from uniform distribution in a circle.
+ * @param a angle result \f$[-\pi, \pi]\f$
+ * @param r radius result \f$[0, 1]\f$
+ */
+inline void lb_sample_circle_uniform_dist(LB_FLOAT& a, LB_FLOAT& r) {
+    lb_sample_circle_uniform_dist(a, r, lb_rng_default());
+}
 
-inline void lb_stratified_random(std::vector<LB_FLOAT>& v, size_t n) {
+/**
+ * Stratified random number, one uniform sample in each of n equal interval of \f$[0,1)\f$.
+ * @param v output
+ * @param n number of sample
+ * @param rng random engine
+ */
+template<typename R>
+inline void lb_stratified_random(std::vector<LB_FLOAT>& v, size_t n, R& rng) {
     LB_FLOAT k = 1.0/n;
     LB_FLOAT k_2 = k * 0.5;
     if(v.size() != n) v.resize(n);
     for(size_t i = 0; i < n; i++) {
-        v[i] = (k_2 + (k*i)) + (lb_rand() * k) - k_2;
+        v[i] = (k_2 + (k*i)) + (lb_rand(rng) * k) - k_2;
     }
 }
 
+inline void lb_stratified_random(std::vector<LB_FLOAT>& v, size_t n) {
+    lb_stratified_random(v, n, lb_rng_default());
+}
+
 /**
  * Compute a cumulative summation.
  * @param v number vector
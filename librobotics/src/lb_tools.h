@@ -48,6 +48,25 @@ namespace librobotics {
       return (unsigned long)(st_time.wMilliseconds + 1000*(st_time.wSecond + 60*(st_time.wMinute + 60*st_time.wHour)));
 #else
       return 0;
+#endif
+    }
+
+    /**
+     * Get current time with microsecond resolution (for profiling)
+     * \return time in microsecond
+     */
+    inline unsigned long utils_get_current_time_us() {
+#if librobotics_OS == 1
+      struct timeval st_time;
+      gettimeofday(&st_time,0);
+      return (unsigned long)(st_time.tv_usec + st_time.tv_sec*1000000);
+#elif librobotics_OS == 2
+      LARGE_INTEGER freq, cnt;
+      QueryPerformanceFrequency(&freq);
+      QueryPerformanceCounter(&cnt);
+      return (unsigned long)((cnt.QuadPart * 1000000) / freq.QuadPart);
+#else
+      return 0;
 #endif
     }
 }
@@ -0,0 +1,104 @@
+/*
+ * test_fast_math.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Error bounds, wrap range and speed of the math policies in lb_fast_math.h.
+ *  Returns non-zero if an error bound is exceeded.
+ */
+
+#include "librobotics.h"
+
+using namespace std;
+using namespace librobotics;
+
+#define N_VALUE (1 << 20)
+#define N_REPEAT 20
+
+static int n_fail = 0;
+
+static void check(const char* name, double err, double bound) {
+    bool ok = err <= bound;
+    printf("  %-24s max error %-10.3g bound %-8.2g %s\n", name, err, bound, ok ? "ok" : "FAIL");
+    if(!ok) n_fail++;
+}
+
+//wrap reference in long double
+static long double ref_wrap(long double a) {
+    const long double pi = 3.14159265358979323846264338327950288L;
+    long double r = fmodl(a + pi, 2 * pi);
+    if(r < 0) r += 2 * pi;
+    return r - pi;
+}
+
+template<typename M, typename T>
+static void check_policy(const char* name, double sincos_bound, double atan2_bound, double wrap_bound) {
+    vector<T> a(N_VALUE), s(N_VALUE), c(N_VALUE), y(N_VALUE), x(N_VALUE), r(N_VALUE);
+    for(int i = 0; i < N_VALUE; i++) {
+        a[i] = (T)((2.0 * i / N_VALUE - 1.0) * 100.0 * M_PI);
+        y[i] = (T)(sin(i * 0.37) * (1 + (i % 7)));
+        x[i] = (T)(cos(i * 0.53) * (1 + (i % 5)));
+    }
+
+    //error
+    double e_sincos = 0, e_atan2 = 0, e_wrap = 0;
+    lb_sincos_array<M>(&a[0], &s[0], &c[0], N_VALUE);
+    lb_atan2_array<M>(&y[0], &x[0], &r[0], N_VALUE);
+    for(int i = 0; i < N_VALUE; i++) {
+        long double ai = a[i];
+        e_sincos = LB_MAX(e_sincos, (double)fabsl(s[i] - sinl(ai)));
+        e_sincos = LB_MAX(e_sincos, (double)fabsl(c[i] - cosl(ai)));
+        e_atan2 = LB_MAX(e_atan2, (double)fabsl(r[i] - atan2l((long double)y[i], (long double)x[i])));
+        //pi and -pi are the same angle
+        long double d = fabsl(M::wrap(a[i]) - ref_wrap(ai));
+        d = LB_MIN(d, fabsl(d - 2 * 3.14159265358979323846264338327950288L));
+        e_wrap = LB_MAX(e_wrap, (double)d);
+    }
+
+    //range [-pi, pi) with pi rounded to T, also at odd multiples of pi
+    int n_out = 0;
+    for(int i = 0; i < N_VALUE; i++) {
+        T w = M::wrap(a[i]);
+        if(!((w >= -(T)M_PI) && (w < (T)M_PI))) n_out++;
+    }
+    for(int k = -100; k <= 100; k++) {
+        T w = M::wrap((T)((2 * k + 1) * M_PI));
+        if(!((w >= -(T)M_PI) && (w < (T)M_PI))) n_out++;
+    }
+
+    //speed
+    unsigned long t0 = utils_get_current_time_us();
+    for(int k = 0; k < N_REPEAT; k++) lb_sincos_array<M>(&a[0], &s[0], &c[0], N_VALUE);
+    unsigned long t1 = utils_get_current_time_us();
+    for(int k = 0; k < N_REPEAT; k++) lb_atan2_array<M>(&y[0], &x[0], &r[0], N_VALUE);
+    unsigned long t2 = utils_get_current_time_us();
+    for(int k = 0; k < N_REPEAT; k++) {
+        r = a;
+        lb_wrap_angle_array<M>(&r[0], N_VALUE);
+    }
+    unsigned long t3 = utils_get_current_time_us();
+
+    const double ns = 1000.0 / ((double)N_VALUE * N_REPEAT);
+    printf("%s (%s)\n", name, sizeof(T) == sizeof(float) ? "float" : "double");
+    check("sincos", e_sincos, sincos_bound);
+    check("atan2", e_atan2, atan2_bound);
+    check("wrap", e_wrap, wrap_bound);
+    printf("  %-24s %-29d %s\n", "wrap out of [-pi, pi)", n_out, n_out ? "FAIL" : "ok");
+    if(n_out) n_fail++;
+    printf("  time sincos %.2f atan2 %.2f wrap %.2f ns/value\n",
+           (t1 - t0) * ns, (t2 - t1) * ns, (t3 - t2) * ns);
+}
+
+int main(int argc, char* argv[]) {
+    check_policy<lb_math_exact, double>("lb_math_exact", 1e-15, 1e-15, 1e-15);
+    check_policy<lb_math_fast, double>("lb_math_fast", 1e-11, 5e-8, 1e-13);
+    check_policy<lb_math_approx, double>("lb_math_approx", 5e-5, 1.5e-5, 1e-13);
+
+    check_policy<lb_math_exact, float>("lb_math_exact", 1e-6, 1e-6, 1e-6);
+    check_policy<lb_math_fast, float>("lb_math_fast", 1e-6, 1e-6, 5e-5);
+    check_policy<lb_math_approx, float>("lb_math_approx", 5e-5, 1.5e-5, 1e-4);
+
+    printf("%s\n", n_fail ? "FAILED" : "PASSED");
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * test_human_check.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Leg pairing of lb_lrf_object_human_check() against a brute-force greedy pairing
+ *  (all leg pairs within max_leg_distance, closest first) on random leg layouts.
+ *  Returns non-zero if the humans differ from the reference.
+ */
+
+#include "librobotics.h"
+
+using namespace std;
+using namespace librobotics;
+
+#define N_TRIAL 200
+
+typedef pair<int, int> leg_pair;
+
+//legs spread around the origin (negative cells too), dense enough for legs with several candidates
+static void random_legs(vector<lrf_object>& objects) {
+    objects.clear();
+    int n = (int)(lb_rand() * 80);
+    LB_FLOAT area = 0.5 + lb_rand() * 3.0;
+    for(int i = 0; i < n; i++) {
+        lrf_object o;
+        o.type = LRF_OBJ_LEG;
+        o.extra_point[0] = vec2f((lb_rand() - 0.5) * area, (lb_rand() - 0.5) * area);
+        o.extra_param[0] = 0.05;
+        o.segment_id = i;
+        o.begin = 4 * i;
+        o.end = o.begin + 4;
+        objects.push_back(o);
+    }
+}
+
+//sorted object index pairs of the greedy closest first matching
+static void ref_pairs(const vector<lrf_object>& objects, const LB_FLOAT max_leg_distance, vector<leg_pair>& pairs) {
+    vector<pair<LB_FLOAT, leg_pair> > candidate;
+    for(size_t i = 0; i < objects.size(); i++) {
+        for(size_t j = i + 1; j < objects.size(); j++) {
+            LB_FLOAT d = (objects[i].extra_point[0] - objects[j].extra_point[0]).size();
+            if(d < max_leg_distance) candidate.push_back(make_pair(d, leg_pair(i, j)));
+        }
+    }
+    sort(candidate.begin(), candidate.end());
+
+    vector<bool> used(objects.size(), false);
+    pairs.clear();
+    for(size_t i = 0; i < candidate.size(); i++) {
+        int a = candidate[i].second.first;
+        int b = candidate[i].second.second;
+        if(used[a] || used[b]) continue;
+        used[a] = used[b] = true;
+        pairs.push_back(candidate[i].second);
+    }
+    sort(pairs.begin(), pairs.end());
+}
+
+int main() {
+    const LB_FLOAT max_leg_distance = 0.4;
+
+    vector<lrf_object> legs;
+    vector<leg_pair> expect, found;
+    lrf_object_arena objects;
+    lb_lrf_human_workspace ws;
+    int n_bad = 0;
+    size_t n_human = 0;
+
+    for(int trial = 0; trial < N_TRIAL; trial++) {
+        random_legs(legs);
+        ref_pairs(legs, max_leg_distance, expect);
+
+        objects.reset();
+        for(size_t i = 0; i < legs.size(); i++) objects.push_back(legs[i]);
+        int n = lb_lrf_object_human_check(objects, max_leg_distance, 0.1, 0.5, ws);
+
+        bool ok = (n == (int)expect.size()) && (objects.size() == legs.size() + expect.size());
+        found.clear();
+        for(size_t k = 0; ok && (k < ws.human.size()); k++) {
+            const lrf_object_record& h = objects[ws.human[k].index];
+            const vec2f& a = legs[ws.human[k].a].extra_point[0];
+            const vec2f& b = legs[ws.human[k].b].extra_point[0];
+            ok = (h.type == LRF_OBJ_HUMAN) &&
+                 ((h.extra_point[0] - (a + b) * 0.5).size() < 1e-9) &&
+                 (fabs(h.extra_param[0] - (a - b).size()) < 1e-9);
+            found.push_back(leg_pair(LB_MIN(ws.human[k].a, ws.human[k].b), LB_MAX(ws.human[k].a, ws.human[k].b)));
+        }
+        sort(found.begin(), found.end());
+        if(!ok || (found != expect)) {
+            printf("trial %d: %lu legs, humans %d, expected %lu\n",
+                   trial, (unsigned long)legs.size(), n, (unsigned long)expect.size());
+            n_bad++;
+        }
+        n_human += expect.size();
+    }
+
+    printf("greedy pairing equal to brute force: %d of %d trials (%.1f humans per trial)\n",
+           N_TRIAL - n_bad, N_TRIAL, n_human / (double)N_TRIAL);
+    printf("%s\n", n_bad ? "FAILED" : "PASSED");
+    return n_bad ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * test_line_extraction.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  lb_lrf_split_and_merge() against lb_lrf_recusive_line_fitting() on random scans,
+ *  allocations when the same frames are processed again with the kept workspace,
+ *  a bent wall that split leaves in pieces and merge must join, and time per scan.
+ *  Returns non-zero if the lines differ, the bent wall is not merged or a frame allocates.
+ */
+
+#include "librobotics.h"
+
+using namespace std;
+using namespace librobotics;
+
+#define N_BEAM 1081
+#define N_SCAN 300
+
+//count allocations of the whole program
+static size_t n_alloc = 0;
+
+void* operator new(size_t size) {
+    n_alloc++;
+    void* p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+void operator delete[](void* p) throw() {
+    operator delete(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t) throw() {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) throw() {
+    operator delete(p);
+}
+#endif
+
+//walls at random distance and direction with noise and random gaps, range in mm
+static void random_scan(const vector<LB_FLOAT>& angle, vector<int>& ranges) {
+    ranges.resize(N_BEAM);
+    int i = 0;
+    while(i < N_BEAM) {
+        int n = 10 + (int)(lb_rand() * 200);
+        bool gap = lb_rand() < 0.1;
+        LB_FLOAT d = 1.0 + lb_rand() * 4.0;
+        LB_FLOAT phi = angle[i] + (lb_rand() - 0.5);
+        for(int k = 0; (k < n) && (i < N_BEAM); k++, i++) {
+            LB_FLOAT c = cos(angle[i] - phi);
+            LB_FLOAT r = (c > 0.3) ? (d / c) : 0;
+            r += (lb_rand() - 0.5) * 0.02;
+            ranges[i] = gap ? 0 : (int)(r * 1000);
+        }
+    }
+}
+
+//short leg, turn of 0.3 rad, wall with a turn of 0.05 rad: the first split is at the
+//small turn, the short leg is split off after, and the two wall pieces fit as one line
+static void bent_wall(vector<vec2f>& points) {
+    points.clear();
+    vec2f p(-1.0, 2.0);
+    LB_FLOAT a = 0;
+    for(int i = 0; i < 120; i++) {
+        if(i == 10) a += 0.3;
+        if(i == 50) a += 0.05;
+        points.push_back(p);
+        p += vec2f(0.02 * cos(a), 0.02 * sin(a));
+    }
+}
+
+static bool same_line(const lrf_object_record& a, const lrf_object_record& b) {
+    LB_FLOAT d = fabs(a.extra_param[2] - b.extra_param[2]) +
+                 fabs(a.extra_point[1].x - b.extra_point[1].x) +
+                 fabs(a.extra_point[1].y - b.extra_point[1].y);
+    return (a.begin == b.begin) && (a.end == b.end) && (a.segment_id == b.segment_id) && (d < 1e-6);
+}
+
+int main() {
+    const LB_FLOAT min_length = 0.1;
+    const LB_FLOAT err_threshold = 0.03;
+
+    vector<LB_FLOAT> cos_table, sin_table, angle(N_BEAM);
+    lb_build_cos_sin_table(LB_DEG2RAD(-135.0), LB_DEG2RAD(135.0), N_BEAM, cos_table, sin_table);
+    for(int i = 0; i < N_BEAM; i++) angle[i] = atan2(sin_table[i], cos_table[i]);
+
+    vector<vector<int> > scans(N_SCAN);
+    for(int f = 0; f < N_SCAN; f++) random_scan(angle, scans[f]);
+
+    vector<int> seg;
+    vector<vec2f> points;
+    vector<lrf_segment_view> views;
+    lb_lrf_line_workspace ws;
+    lrf_object_arena recursive, split, merged;
+
+    int n_differ = 0, n_error = 0;
+    size_t n_line = 0, n_merged = 0, frame_alloc = 0;
+    unsigned long t_recursive = 0, t_split = 0, t_merge = 0;
+
+    //pass 0 grows the workspace and the arenas, pass 1 must not allocate
+    for(int pass = 0; pass < 2; pass++) {
+        for(int f = 0; f < N_SCAN; f++) {
+            lb_lrf_get_scan_point_from_scan_range(scans[f], cos_table, sin_table, points, 0, N_BEAM - 1, 1, 0.001);
+            lb_lrf_range_segment(scans[f], seg, 100);
+            lb_lrf_get_segment_view(seg, views);
+
+            recursive.reset();
+            split.reset();
+            merged.reset();
+
+            unsigned long t0 = utils_get_current_time_us();
+            for(size_t k = 0; k < views.size(); k++) {
+                lb_lrf_recusive_line_fitting(points, views[k], recursive, min_length, err_threshold);
+            }
+            unsigned long t1 = utils_get_current_time_us();
+            size_t a0 = n_alloc;
+            for(size_t k = 0; k < views.size(); k++) {
+                lb_lrf_split_and_merge(points, views[k], split, min_length, err_threshold, ws, false);
+            }
+            unsigned long t2 = utils_get_current_time_us();
+            for(size_t k = 0; k < views.size(); k++) {
+                lb_lrf_split_and_merge(points, views[k], merged, min_length, err_threshold, ws, true);
+            }
+            unsigned long t3 = utils_get_current_time_us();
+            size_t a1 = n_alloc;
+
+            if(pass == 0) {
+                bool differ = recursive.size() != split.size();
+                for(size_t k = 0; !differ && (k < split.size()); k++) {
+                    differ = !same_line(recursive[k], split[k]);
+                }
+                if(differ) n_differ++;
+                for(size_t k = 0; k < merged.size(); k++) {
+                    if(merged[k].extra_param[2] >= err_threshold) n_error++;
+                }
+                n_line += split.size();
+                n_merged += merged.size();
+            } else {
+                frame_alloc += a1 - a0;
+                t_recursive += t1 - t0;
+                t_split += t2 - t1;
+                t_merge += t3 - t2;
+            }
+        }
+    }
+
+    bent_wall(points);
+    split.reset();
+    merged.reset();
+    lb_lrf_split_and_merge(points, lrf_segment_view(0, points.size(), 0), split, min_length, err_threshold, ws, false);
+    lb_lrf_split_and_merge(points, lrf_segment_view(0, points.size(), 0), merged, min_length, err_threshold, ws, true);
+    bool bent_merged = merged.size() < split.size();
+    for(size_t k = 0; k < merged.size(); k++) {
+        if(merged[k].extra_param[2] >= err_threshold) bent_merged = false;
+    }
+
+    printf("split (merge = false) equal to recursive fitting: %d of %d scans\n", N_SCAN - n_differ, N_SCAN);
+    printf("merged lines over err_threshold: %d\n", n_error);
+    printf("allocations in %d repeated frames with kept workspace: %lu\n", N_SCAN, (unsigned long)frame_alloc);
+    printf("lines per scan: split %.1f, merged %.1f\n", n_line / (double)N_SCAN, n_merged / (double)N_SCAN);
+    printf("bent wall: split %lu lines, merged %lu lines %s\n",
+           (unsigned long)split.size(), (unsigned long)merged.size(), bent_merged ? "ok" : "FAIL");
+    printf("time per scan: recursive %.1f us, split %.1f us, split and merge %.1f us\n",
+           t_recursive / (double)N_SCAN, t_split / (double)N_SCAN, t_merge / (double)N_SCAN);
+
+    bool ok = (n_differ == 0) && (n_error == 0) && (frame_alloc == 0) && bent_merged;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -27,9 +27,9 @@ int main(int argc, char* argv[]) {
     lb_mcl_grid2_data mcl_data;
     mcl_data.initialize(mcl_cfg);
 
-    lb_init_particle2(mcl_data.p, mcl_data.map, 4, pose2f(4.0, 7.5, 0.0), 1.0, 0.2);
+    lb_init_particle2(mcl_data.p, *mcl_data.map, 4, pose2f(4.0, 7.5, 0.0), 1.0, 0.2);
 
-    cimg8u map = mcl_data.map.get_image().resize_doubleXY();
+    cimg8u map = mcl_data.map->get_image().resize_doubleXY();
     disp.disp.resize(map);
 
 
@@ -60,8 +60,8 @@ int main(int argc, char* argv[]) {
         tmp = map;
 
         vec2f map_pts;
-        mcl_data.map.get_grid_position(disp.mouse.x/ZOOM, disp.mouse.y/ZOOM, map_pts);
-        lb_draw_map2_grid_ray_cast(tmp, disp.mouse / 2, mcl_data.map, red, ZOOM, 0.0, 0.0, 0.0);
+        mcl_data.map->get_grid_position(disp.mouse.x/ZOOM, disp.mouse.y/ZOOM, map_pts);
+        lb_draw_map2_grid_ray_cast(tmp, disp.mouse / 2, *mcl_data.map, red, ZOOM, 0.0, 0.0, 0.0);
 
 
 
@@ -73,18 +73,18 @@ int main(int argc, char* argv[]) {
             lb_draw_points_cimg(lrf_img, pts, red, 100.0, 0.0);
             lrf_img.display(lrf_disp.disp);
 
-            start_time = utils_get_current_time();
-            lb_mcl_grid2_update_with_odomety(mcl_cfg, pts, log.odo, mcl_data, 60);
-            used_time = utils_get_current_time() - start_time;
-            LB_PRINT_VAR(used_time);
+            if(lb_mcl_grid2_update_with_odomety(mcl_cfg, pts, log.odo, mcl_data, 60)) {
+                LB_PRINT_VAR(mcl_data.update_time);
+                LB_PRINT_VAR(mcl_data.update_evaluations);
 
-            start_time = utils_get_current_time();
-            lb_particle_stratified_resample(mcl_data.p, 500);
-            used_time = utils_get_current_time() - start_time;
-            LB_PRINT_VAR(used_time);
+                start_time = utils_get_current_time();
+                lb_particle_stratified_resample(mcl_data.p, 500);
+                used_time = utils_get_current_time() - start_time;
+                LB_PRINT_VAR(used_time);
+            }
 
 
-            lb_draw_paticle2(tmp, mcl_data.p, mcl_data.map, red, 3, ZOOM, 0.0, 0, 0, true);
+            lb_draw_paticle2(tmp, mcl_data.p, *mcl_data.map, red, 3, ZOOM, 0.0, 0, 0, true);
 
         }
         tmp.display(disp.disp);
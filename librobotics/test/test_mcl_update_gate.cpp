@@ -0,0 +1,74 @@
+/*
+ * test_mcl_update_gate.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Update thresholds of MCL (cfg.update_min_d, cfg.update_min_a) with one, both
+ *  or no threshold set, for the odometry and the velocity update.
+ *  Returns non-zero if an update is run or skipped wrongly.
+ */
+
+#include "librobotics.h"
+
+using namespace std;
+using namespace librobotics;
+
+struct gate_case {
+    LB_FLOAT min_d, min_a;      //thresholds (0 off)
+    LB_FLOAT d, a;              //motion since the last update
+    bool update;                //expected
+};
+
+static const gate_case cases[] = {
+    { 0.0, 0.0, 0.01, 0.0, true },      //no threshold, every motion
+    { 0.0, 0.0, 0.0, 0.0, true },
+    { 0.5, 0.0, 0.01, 0.0, false },     //distance only
+    { 0.5, 0.0, 0.01, 1.0, false },
+    { 0.5, 0.0, 0.6, 0.0, true },
+    { 0.0, 0.3, 0.01, 0.1, false },     //rotation only
+    { 0.0, 0.3, 2.0, 0.1, false },
+    { 0.0, 0.3, 0.0, 0.4, true },
+    { 0.5, 0.3, 0.1, 0.1, false },      //both, either one triggers
+    { 0.5, 0.3, 0.6, 0.0, true },
+    { 0.5, 0.3, 0.0, 0.4, true },
+};
+
+int main() {
+    int n_fail = 0;
+    const int n_case = sizeof(cases) / sizeof(cases[0]);
+    vector<vec2f> z;
+    vector<int> beam_index;
+
+    for(int i = 0; i < n_case; i++) {
+        const gate_case& c = cases[i];
+        lb_mcl_grid2_configuration cfg;
+        cfg.n_particles = 0;
+        cfg.update_min_d = c.min_d;
+        cfg.update_min_a = c.min_a;
+
+        lb_mcl_grid2_data data;
+        data.map = lb_mcl_grid2_data::shared_map_type(new lb_mcl_grid2_data::map_type());
+        data.force_update = false;
+        data.last_odo_pose = pose2f();
+        pose2f odo_pose(c.d, (LB_FLOAT)0, c.a);
+
+        bool need = lb_mcl_grid2_need_update(cfg, odo_pose, data);
+        bool odometry = lb_mcl_grid2_update_with_odomety(cfg, z, beam_index, odo_pose, data) == 1;
+
+        lb_mcl_grid2_data vdata;
+        vdata.map = data.map;
+        vdata.force_update = false;
+        vdata.motion_d = c.d;
+        vdata.motion_a = c.a;
+        bool velocity = lb_mcl_grid2_update_with_velocity(cfg, z, beam_index, vdata) == 1;
+
+        bool ok = (need == c.update) && (odometry == c.update) && (velocity == c.update);
+        printf("min_d %.1f min_a %.1f motion %.2f %.2f: need_update %d odometry %d velocity %d expected %d %s\n",
+               c.min_d, c.min_a, c.d, c.a, need, odometry, velocity, c.update, ok ? "ok" : "FAIL");
+        if(!ok) n_fail++;
+    }
+
+    printf("%s\n", n_fail ? "FAILED" : "PASSED");
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * test_median_filter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: agent
+ *
+ *  Brute-force check and throughput of lb_lrf_range_median_filter().
+ *  Returns non-zero if an output differs from the reference.
+ */
+
+#include "librobotics.h"
+
+using namespace std;
+using namespace librobotics;
+
+#define N_TRIAL 2000
+#define N_SCAN 2000
+
+//sort each window with edge replication (the filter before lb_median_filter.h)
+template<typename T>
+static void ref_median(const vector<T>& in, vector<T>& out, int h) {
+    int n = in.size();
+    out.resize(n);
+    vector<T> w((2 * h) + 1);
+    for(int i = 0; i < n; i++) {
+        for(int k = 0; k < (2 * h) + 1; k++) {
+            w[k] = in[LB_MIN(LB_MAX(i + k - h, 0), n - 1)];
+        }
+        std::sort(w.begin(), w.end());
+        out[i] = w[h];
+    }
+}
+
+//0-1 principle: a network that sorts all 0/1 inputs selects the median of any input
+template<int W>
+static bool check_network() {
+    for(int m = 0; m < (1 << W); m++) {
+        int v[W];
+        int ones = 0;
+        for(int k = 0; k < W; k++) {
+            v[k] = (m >> k) & 1;
+            ones += v[k];
+        }
+        if(lb_median_network<W>::median(v) != (ones > W / 2)) return false;
+    }
+    return true;
+}
+
+template<typename T>
+static int check_random(T max_value) {
+    int n_bad = 0;
+    lb_sliding_median_t<T> ws;
+    vector<T> in, out, in_place, expect;
+    for(int trial = 0; trial < N_TRIAL; trial++) {
+        int n = 1 + (int)(lb_rand() * 200);
+        int h = (int)(lb_rand() * 25);
+        in.resize(n);
+        for(int i = 0; i < n; i++) in[i] = (T)(lb_rand() * max_value);
+        ref_median(in, expect, h);
+
+        lb_lrf_range_median_filter(in, out, h, ws);
+        if(out != expect) n_bad++;
+        in_place = in;
+        lb_lrf_range_median_filter(in_place, h);
+        if(in_place != expect) n_bad++;
+    }
+    return n_bad;
+}
+
+static void benchmark(int n, int h) {
+    vector<unsigned short> in(n), out, expect;
+    for(int i = 0; i < n; i++) in[i] = (unsigned short)(lb_rand() * 30000);
+    lb_sliding_median_t<unsigned short> ws;
+
+    unsigned long t0 = utils_get_current_time_us();
+    for(int k = 0; k < N_SCAN; k++) {
+        in[k % n]++;
+        lb_lrf_range_median_filter(in, out, h, ws);
+    }
+    unsigned long t1 = utils_get_current_time_us();
+    for(int k = 0; k < N_SCAN / 20; k++) {
+        in[k % n]++;
+        ref_median(in, expect, h);
+    }
+    unsigned long t2 = utils_get_current_time_us();
+
+    printf("  %5d beams window %2d: %8.2f us/scan, sort per beam %8.2f us/scan\n",
+           n, (2 * h) + 1, (t1 - t0) / (double)N_SCAN, (t2 - t1) / (double)(N_SCAN / 20));
+}
+
+int main(int argc, char* argv[]) {
+    int n_fail = 0;
+
+    bool net = check_network<3>() && check_network<5>() && check_network<7>() && check_network<9>();
+    printf("median networks on all 0/1 inputs: %s\n", net ? "ok" : "FAIL");
+    if(!net) n_fail++;
+
+    int bad_int = check_random<int>(20);
+    int bad_ushort = check_random<unsigned short>(30000);
+    int bad_float = check_random<float>(10.0f);
+    printf("mismatch over %d random sizes and windows: int %d, unsigned short %d, float %d\n",
+           N_TRIAL, bad_int, bad_ushort, bad_float);
+    n_fail += bad_int + bad_ushort + bad_float;
+
+    printf("throughput\n");
+    int beams[2] = { 769, 1081 };
+    int half_window[6] = { 1, 2, 3, 4, 8, 20 };
+    for(int b = 0; b < 2; b++) {
+        for(int w = 0; w < 6; w++) {
+            benchmark(beams[b], half_window[w]);
+        }
+    }
+
+    printf("%s\n", n_fail ? "FAILED" : "PASSED");
+    return n_fail ? 1 : 0;
+}